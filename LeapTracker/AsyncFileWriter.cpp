@@ -0,0 +1,209 @@
+//
+//  AsyncFileWriter.cpp
+//  LeapTracker
+//
+#include "AsyncFileWriter.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+AsyncFileWriter::AsyncFileWriter() : appendedBytes(0), journalCommitted(0), closing(false) {}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
+
+bool AsyncFileWriter::open(const std::string& filePath) {
+    return open(filePath, Options());
+}
+
+bool AsyncFileWriter::open(const std::string& filePath, const Options& writerOptions) {
+    return open(filePath, writerOptions, std::string());
+}
+
+bool AsyncFileWriter::open(const std::string& filePath, const Options& writerOptions, const std::string& preamble) {
+    close();
+    options = writerOptions;
+    options.file.syncFinishedParts = options.syncPolicy != SyncPolicy::Never;
+    if (!file.open(filePath, options.file, preamble)) {
+        return false;
+    }
+    appendedBytes = 0;
+    journalBoundaries.clear();
+    if (options.journalBytes > 0) {
+        if (!journal.open(file.path() + ".journal", options.journalBytes)) {
+            file.close(false);
+            return false;
+        }
+        journalBoundaries.push_back({ 0, journal.head() });
+        journalCommittedPart.clear();
+        commitJournal();
+    }
+    // Touch every page now so the first appends do not page-fault
+    active.resize(options.bufferBytes);
+    writing.resize(options.bufferBytes);
+    active.clear();
+    writing.clear();
+    counters = Stats();
+    collectFileStats();
+    closing = false;
+    thread = std::thread(&AsyncFileWriter::run, this);
+    return true;
+}
+
+void AsyncFileWriter::append(const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active.empty()) {
+        pendingSince = Clock::now();
+    }
+    if (active.size() + size > active.capacity()) {
+        counters.bufferGrowths++;
+    }
+    active.insert(active.end(), data, data + size);
+    if (journal.isOpen()) {
+        if (journal.uncommittedBytes() + size > journal.capacity()) {
+            counters.journalOverruns++;
+        }
+        journal.append(data, size, appendedBytes);
+    }
+    appendedBytes += size;
+    counters.maxPendingBytes = std::max(counters.maxPendingBytes, active.size());
+    // Wake the writer once per batch, when the batch reaches flushBytes
+    if (active.size() >= options.flushBytes && active.size() - size < options.flushBytes) {
+        wake.notify_one();
+    }
+}
+
+void AsyncFileWriter::close() {
+    if (!thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    wake.notify_one();
+    thread.join();
+
+    file.close(options.syncPolicy != SyncPolicy::Never);
+    std::lock_guard<std::mutex> lock(mutex);
+    collectFileStats();
+    // Kept for LeapJournalRecover if any rows failed to reach the file
+    journal.close(counters.writeErrors == 0);
+}
+
+AsyncFileWriter::Stats AsyncFileWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats = counters;
+    stats.pendingBytes = active.size() + writing.size();
+    return stats;
+}
+
+void AsyncFileWriter::run() {
+    Clock::time_point lastSync = Clock::now();
+    Clock::time_point lastJournalSync = lastSync;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait_for(lock, options.flushInterval, [this] {
+            return closing || active.size() >= options.flushBytes;
+        });
+        if (active.empty()) {
+            if (closing) {
+                break;
+            }
+            // Compressed blocks and timed parts still finish when no rows arrive
+            lock.unlock();
+            Clock::time_point now = Clock::now();
+            bool polled = file.poll(now);
+            commitJournal();
+            if (journal.isOpen() && now - lastJournalSync >= options.journalSyncInterval) {
+                journal.sync();
+                lastJournalSync = now;
+            }
+            lock.lock();
+            if (!polled) {
+                counters.writeErrors++;
+            }
+            collectFileStats();
+            continue;
+        }
+
+        // Take the whole batch and write it without holding the lock
+        std::swap(active, writing);
+        Clock::time_point batchSince = pendingSince;
+        if (journal.isOpen()) {
+            journalBoundaries.push_back({ appendedBytes, journal.head() });
+        }
+        lock.unlock();
+
+        Clock::time_point now = Clock::now();
+        // A new part is committed before the batch goes into it; otherwise a crash between the
+        // write and the commit would leave recovery appending the batch to the old part again
+        bool written = file.rotateIfDue(now);
+        commitJournal();
+        written = file.write(writing.data(), writing.size(), now) && written;
+        if (options.syncPolicy == SyncPolicy::Interval && now - lastSync >= options.syncInterval) {
+            file.sync();
+            lastSync = now;
+        }
+        commitJournal();
+        if (journal.isOpen() && now - lastJournalSync >= options.journalSyncInterval) {
+            journal.sync();
+            lastJournalSync = now;
+        }
+        int64_t lag = std::chrono::duration_cast<std::chrono::microseconds>(now - batchSince).count();
+
+        lock.lock();
+        if (!written) {
+            counters.writeErrors++;
+        }
+        collectFileStats();
+        counters.lagMicros = lag;
+        counters.maxLagMicros = std::max(counters.maxLagMicros, lag);
+        writing.clear();
+    }
+}
+
+void AsyncFileWriter::commitJournal() {
+    if (!journal.isOpen() || !file.isOpen()) {
+        return;
+    }
+    // The file holds whole batches, so what it has ends at a batch boundary
+    uint64_t durable = file.stats().rowBytes;
+    while (journalBoundaries.size() > 1 && journalBoundaries[1].first <= durable) {
+        journalBoundaries.pop_front();
+    }
+    const std::pair<uint64_t, uint64_t>& boundary = journalBoundaries.front();
+    if (boundary.first != durable || (durable == journalCommitted && file.path() == journalCommittedPart)) {
+        return;
+    }
+    journal.commit(file.path(), file.partSize(), durable, boundary.second, file.isCompressed());
+    journalCommitted = durable;
+    journalCommittedPart = file.path();
+}
+
+void AsyncFileWriter::collectFileStats() {
+    const LogFile::Stats& fileStats = file.stats();
+    counters.bytesWritten = fileStats.bytesWritten;
+    counters.rawBytes = fileStats.rawBytes;
+    counters.writes = fileStats.writes;
+    counters.syncs = fileStats.syncs;
+    counters.blocks = fileStats.blocks;
+    counters.parts = fileStats.parts;
+}
+
+void AsyncFileWriter::parseSyncPolicy(const std::string& value, Options& options) {
+    if (value == "never") {
+        options.syncPolicy = SyncPolicy::Never;
+    } else if (value == "stop") {
+        options.syncPolicy = SyncPolicy::AtStop;
+    } else {
+        double seconds = std::stod(value);
+        if (!(seconds > 0)) {
+            throw std::invalid_argument("Sync interval must be positive: " + value);
+        }
+        options.syncPolicy = SyncPolicy::Interval;
+        options.syncInterval = std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000));
+    }
+}
+
+// end of AsyncFileWriter.cpp //
@@ -0,0 +1,121 @@
+//
+//  AsyncFileWriter.hpp
+//  LeapTracker
+//
+//  Append-only file written from its own thread, used for the CSV log so a
+//  slow disk (USB drive, network home directory) stalls the writer thread
+//  instead of frame processing. append() copies into the active half of a
+//  preallocated double buffer; the writer thread swaps the halves and
+//  writes the whole batch with one write() call, every flushInterval or as
+//  soon as flushBytes are pending. If the disk falls so far behind that the
+//  active half fills, it grows rather than dropping rows, and the growth is
+//  counted in Stats. The file itself is a LogFile, which can compress the
+//  batches and split the log into parts. With journalBytes set, appends
+//  are also copied into a SessionJournal so a crash loses none of them.
+//
+#ifndef AsyncFileWriter_hpp
+#define AsyncFileWriter_hpp
+
+#include "LogFile.hpp"
+#include "SessionJournal.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AsyncFileWriter {
+public:
+    enum class SyncPolicy {
+        Never,      // leave it to the OS
+        Interval,   // fsync at most every syncInterval, after a batch is written
+        AtStop      // fsync once when the file is closed
+    };
+
+    struct Options {
+        size_t bufferBytes = 1 << 20;                                   // per half, preallocated
+        size_t flushBytes = 256 << 10;                                  // write as soon as this much is pending
+        std::chrono::milliseconds flushInterval{100};                   // otherwise write this often
+        SyncPolicy syncPolicy = SyncPolicy::AtStop;
+        std::chrono::milliseconds syncInterval{5000};
+        LogFile::Options file;                                          // compression and rotation
+        size_t journalBytes = 0;                                        // crash journal ring size; 0 for none
+        std::chrono::milliseconds journalSyncInterval{1000};            // msync the journal this often
+    };
+
+    struct Stats {
+        uint64_t bytesWritten = 0;      // on disk
+        uint64_t rawBytes = 0;          // before compression
+        uint64_t writes = 0;
+        uint64_t syncs = 0;
+        uint64_t bufferGrowths = 0;     // appends that found the active half full
+        uint64_t writeErrors = 0;
+        uint64_t blocks = 0;            // zstd frames written
+        uint64_t parts = 0;             // files the log has been split into
+        uint64_t journalOverruns = 0;   // appends that overwrote journal entries the log did not have yet
+        size_t pendingBytes = 0;        // appended but not yet written
+        size_t maxPendingBytes = 0;
+        int64_t lagMicros = 0;          // age of the oldest row in the last batch when it was written
+        int64_t maxLagMicros = 0;
+    };
+
+    AsyncFileWriter();
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // Creates or truncates the file and starts the writer thread. preamble
+    // starts the file and every later part of it.
+    bool open(const std::string& path, const Options& options, const std::string& preamble);
+    bool open(const std::string& path, const Options& options);
+    bool open(const std::string& path);
+    bool isOpen() const { return file.isOpen(); }
+    // The part being written; only stable while the writer thread is stopped
+    const std::string& path() const { return file.path(); }
+
+    // Any one thread; never blocks on the disk
+    void append(const char* data, size_t size);
+    void append(const std::string& data) { append(data.data(), data.size()); }
+
+    // Writes everything pending, syncs if the policy asks, and stops the thread
+    void close();
+
+    Stats stats() const;
+
+    // "never", "stop", or a number of seconds between syncs
+    static void parseSyncPolicy(const std::string& value, Options& options);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Options options;
+    LogFile file;                   // writer thread only while it runs
+    SessionJournal journal;         // appended to under mutex, committed from the writer thread
+    uint64_t appendedBytes;         // under mutex
+    // Writer thread: where each batch boundary (stream offset) lies in the journal ring
+    std::deque<std::pair<uint64_t, uint64_t>> journalBoundaries;
+    uint64_t journalCommitted;
+    std::string journalCommittedPart;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<char> active;       // appended to under mutex
+    std::vector<char> writing;      // owned by the writer thread between swaps
+    Clock::time_point pendingSince; // when active last went from empty to non-empty
+    bool closing;
+    Stats counters;
+    std::thread thread;
+
+    void run();
+    // With mutex held
+    void collectFileStats();
+    // Writer thread: records in the journal how much of the log is on disk
+    void commitJournal();
+};
+
+#endif /* AsyncFileWriter_hpp */
@@ -0,0 +1,144 @@
+//
+//  CalibrationCache.cpp
+//  LeapTracker
+//
+#include "CalibrationCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+void PatientCalibration::setRange(int hand, MetricId id, float rangeLow, float rangeHigh, uint32_t frameCount) {
+    size_t m = static_cast<size_t>(id);
+    calibrated[hand][m] = true;
+    low[hand][m] = rangeLow;
+    high[hand][m] = rangeHigh;
+    frames[hand][m] = frameCount;
+    hands[hand][id] = MetricScale::fromRange(id, rangeLow, rangeHigh);
+}
+
+bool PatientCalibration::load(const std::string& path) {
+    std::ifstream file(path, std::ifstream::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    CalibrationFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != CALIBRATION_FILE_MAGIC || header.version != CALIBRATION_FILE_VERSION) {
+        std::cerr << "Ignoring calibration file with unknown format: " << path << std::endl;
+        return false;
+    }
+    // entryCount comes from disk; check it against what the file holds before allocating
+    std::streamoff entriesStart = file.tellg();
+    file.seekg(0, std::ifstream::end);
+    std::streamoff entryBytes = file.tellg() - entriesStart;
+    file.seekg(entriesStart);
+    if (entryBytes < 0 || static_cast<uint64_t>(header.entryCount) * sizeof(CalibrationFileEntry) > static_cast<uint64_t>(entryBytes)) {
+        std::cerr << "Ignoring truncated calibration file: " << path << std::endl;
+        return false;
+    }
+    std::vector<CalibrationFileEntry> entries(header.entryCount);
+    if (!file.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(CalibrationFileEntry))) {
+        std::cerr << "Ignoring truncated calibration file: " << path << std::endl;
+        return false;
+    }
+
+    for (const CalibrationFileEntry& entry : entries) {
+        if (entry.hand >= kHandSlots || !(entry.high > entry.low)) {
+            continue;
+        }
+        for (size_t m = 0; m < kMetricCount; m++) {
+            if (strncmp(entry.metric, kMetricInfo[m].jsonKey, sizeof(entry.metric)) == 0) {
+                setRange(static_cast<int>(entry.hand), static_cast<MetricId>(m), entry.low, entry.high, entry.frames);
+            }
+        }
+    }
+    return true;
+}
+
+bool PatientCalibration::save(const std::string& path) const {
+    std::vector<CalibrationFileEntry> entries;
+    for (uint32_t hand = 0; hand < kHandSlots; hand++) {
+        for (size_t m = 0; m < kMetricCount; m++) {
+            if (!calibrated[hand][m]) {
+                continue;
+            }
+            CalibrationFileEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            strncpy(entry.metric, kMetricInfo[m].jsonKey, sizeof(entry.metric) - 1);
+            entry.hand = hand;
+            entry.frames = frames[hand][m];
+            entry.low = low[hand][m];
+            entry.high = high[hand][m];
+            entries.push_back(entry);
+        }
+    }
+
+    // Write to a temporary file and rename, so a crash never leaves half a cache
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ofstream::binary | std::ofstream::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open calibration file at: " << temporaryPath << std::endl;
+        return false;
+    }
+    CalibrationFileHeader header = { CALIBRATION_FILE_MAGIC, CALIBRATION_FILE_VERSION, static_cast<uint32_t>(entries.size()), 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(CalibrationFileEntry));
+    file.close();
+    if (!file || std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to write calibration file at: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string PatientCalibration::pathFor(const std::string& directory, const std::string& clientName) {
+    std::string path = directory.empty() ? "." : directory;
+    if (path.back() != '/') {
+        path += '/';
+    }
+    return path + (clientName.empty() ? "UnknownClient" : clientName) + ".calibration";
+}
+
+CalibrationRecorder::CalibrationRecorder(const ExercisePipeline& pipeline) : pipeline(pipeline) {}
+
+void CalibrationRecorder::record(eLeapHandType hand, const float* raw) {
+    QuantileSketch* handSketches = sketches[handSlot(hand)];
+    for (size_t m = 0; m < pipeline.metricCount; m++) {
+        handSketches[m].add(raw[m]);
+    }
+}
+
+int CalibrationRecorder::apply(PatientCalibration& calibration) const {
+    int kept = 0;
+    for (int hand = 0; hand < kHandSlots; hand++) {
+        for (size_t m = 0; m < pipeline.metricCount; m++) {
+            MetricId id = pipeline.metrics[m];
+            const MetricInfo& info = metricInfo(id);
+            const QuantileSketch& sketch = sketches[hand][m];
+            if (sketch.count() == 0) {
+                continue;
+            }
+
+            // Percentiles rather than extremes, so a few glitched frames do not widen the range
+            float rangeLow = static_cast<float>(sketch.quantile(0.02));
+            float rangeHigh = static_cast<float>(sketch.quantile(0.98));
+            float minimumSpan = kMinSpanFraction * (info.defaultHigh - info.defaultLow);
+            if (sketch.count() < kMinFrames || !(rangeHigh - rangeLow >= minimumSpan)) {
+                std::cout << "Calibration " << handSlotName(hand) << " " << info.csvColumn << ": range too small ("
+                          << sketch.count() << " frames, " << rangeLow << " to " << rangeHigh << "), keeping "
+                          << (calibration.calibrated[hand][static_cast<size_t>(id)] ? "previous" : "default") << " range" << std::endl;
+                continue;
+            }
+            calibration.setRange(hand, id, rangeLow, rangeHigh, static_cast<uint32_t>(sketch.count()));
+            std::cout << "Calibration " << handSlotName(hand) << " " << info.csvColumn << ": " << rangeLow << " to " << rangeHigh
+                      << " (default " << info.defaultLow << " to " << info.defaultHigh << ")" << std::endl;
+            kept++;
+        }
+    }
+    return kept;
+}
+
+// end of CalibrationCache.cpp //
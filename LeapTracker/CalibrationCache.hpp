@@ -0,0 +1,86 @@
+//
+//  CalibrationCache.hpp
+//  LeapTracker
+//
+//  Per-patient metric ranges. A calibration session (--calibrate) records
+//  the raw quantity behind each of its exercise's metrics, per hand, and at
+//  stop saves the 2nd to 98th percentile range to <clientName>.calibration.
+//  Later sessions for the same client load the file at startup and map
+//  those ranges to 0..1, so a patient with limited mobility still spans the
+//  whole metric. Metrics a patient has not calibrated keep the defaults in
+//  kMetricInfo.
+//
+//  Layout (native endianness, like frame recordings):
+//    CalibrationFileHeader
+//    CalibrationFileEntry[entryCount]
+//
+#ifndef CalibrationCache_hpp
+#define CalibrationCache_hpp
+
+#include "LeapC.h"
+#include "ExerciseMetrics.hpp"
+#include "QuantileSketch.hpp"
+#include <cstdint>
+#include <string>
+
+#define CALIBRATION_FILE_MAGIC 0x4C41434C  // "LCAL"
+#define CALIBRATION_FILE_VERSION 1
+
+struct CalibrationFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+// Entries are matched to metrics by jsonKey, so adding or reordering
+// metrics does not invalidate existing files
+struct CalibrationFileEntry {
+    char metric[32];
+    uint32_t hand;      // 0 left, 1 right
+    uint32_t frames;    // frames the range was observed over
+    float low;          // raw quantity mapped to 0
+    float high;         // raw quantity mapped to 1
+};
+
+struct PatientCalibration {
+    // Indexed by handSlot(), then MetricId
+    bool calibrated[kHandSlots][kMetricCount] = {};
+    float low[kHandSlots][kMetricCount] = {};
+    float high[kHandSlots][kMetricCount] = {};
+    uint32_t frames[kHandSlots][kMetricCount] = {};
+    // Scale/offset pairs the metric kernels use, kept in step with the ranges
+    MetricCalibration hands[kHandSlots] = { MetricCalibration::defaults(), MetricCalibration::defaults() };
+
+    const MetricCalibration& forHand(eLeapHandType hand) const { return hands[handSlot(hand)]; }
+    void setRange(int hand, MetricId id, float rangeLow, float rangeHigh, uint32_t frameCount);
+
+    // Missing files leave the defaults and return false; corrupt ones also print why
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    static std::string pathFor(const std::string& directory, const std::string& clientName);
+};
+
+// Collects raw metric quantities during a calibration session
+class CalibrationRecorder {
+public:
+    // A range needs this many frames and at least this fraction of the default span to be kept
+    static const uint32_t kMinFrames = 120;
+    static constexpr float kMinSpanFraction = 0.1f;
+
+    explicit CalibrationRecorder(const ExercisePipeline& pipeline);
+
+    // raw holds the pipeline's metrics computed with MetricCalibration::identity()
+    void record(eLeapHandType hand, const float* raw);
+
+    // Writes the recorded ranges into calibration and prints them; returns how many were kept
+    int apply(PatientCalibration& calibration) const;
+
+private:
+    const ExercisePipeline& pipeline;
+    // Indexed by handSlot(), then pipeline position
+    QuantileSketch sketches[kHandSlots][kMetricCount];
+};
+
+#endif /* CalibrationCache_hpp */
@@ -0,0 +1,204 @@
+//
+//  ChannelFilter.cpp
+//  LeapTracker
+//
+#include "ChannelFilter.hpp"
+#include "SimdOps.hpp"
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const float kTwoPi = 6.28318530717959f;
+
+// Smoothing factor of a first-order low-pass filter with cutoff fc, for a
+// step of dt: r / (1 + r) with r = 2 pi fc dt
+inline vfloat lowPassAlpha(vfloat cutoff, vfloat twoPiDt) {
+    vfloat r = vmul(cutoff, twoPiDt);
+    return vdiv(r, vadd(vset(1.0f), r));
+}
+
+// Speeds decay geometrically towards zero while a channel holds still; stop
+// them before they become denormal, which is many times slower to compute with
+inline vfloat flushTiny(vfloat a) {
+    return vselect(vgreater(vabs(a), vset(1e-12f)), a, vset(0.0f));
+}
+
+// Brings a value within half a period of 0; inputs are at most one period out of range.
+// halfPeriod is infinite for linear channels, which are returned unchanged
+inline vfloat wrapCircular(vfloat a, vfloat period, vfloat halfPeriod) {
+    a = vselect(vgreater(a, halfPeriod), vsub(a, period), a);
+    return vselect(vgreater(vsub(vset(0.0f), halfPeriod), a), vadd(a, period), a);
+}
+
+int paddedCount(int channelCount) {
+    return (channelCount + kWidth - 1) / kWidth * kWidth;
+}
+
+}  // namespace
+
+ChannelFilter::ChannelFilter(Type type, int channelCount)
+    : filterType(type), channels(channelCount), primed(false), lastTimestamp(0)
+{
+    if (channelCount <= 0) {
+        throw std::invalid_argument("Channel filter needs at least one channel");
+    }
+    size_t padded = static_cast<size_t>(paddedCount(channelCount));
+    Parameters defaults;
+    minCutoff.assign(padded, defaults.minCutoff);
+    beta.assign(padded, defaults.beta);
+    derivativeCutoff.assign(padded, defaults.derivativeCutoff);
+    processNoise.assign(padded, defaults.processNoise);
+    measurementNoise.assign(padded, defaults.measurementNoise);
+    period.assign(padded, 0.0f);
+    halfPeriod.assign(padded, std::numeric_limits<float>::infinity());
+    estimate.assign(padded, 0.0f);
+    speed.assign(padded, 0.0f);
+    p00.assign(padded, 0.0f);
+    p01.assign(padded, 0.0f);
+    p11.assign(padded, 0.0f);
+}
+
+void ChannelFilter::setParameters(int channel, const Parameters& parameters) {
+    if (channel < 0 || channel >= channels) {
+        throw std::out_of_range("Channel filter has no channel " + std::to_string(channel));
+    }
+    minCutoff[channel] = parameters.minCutoff;
+    beta[channel] = parameters.beta;
+    derivativeCutoff[channel] = parameters.derivativeCutoff;
+    processNoise[channel] = parameters.processNoise;
+    measurementNoise[channel] = parameters.measurementNoise;
+    period[channel] = parameters.period > 0.0f ? parameters.period : 0.0f;
+    halfPeriod[channel] = parameters.period > 0.0f ? 0.5f * parameters.period : std::numeric_limits<float>::infinity();
+}
+
+void ChannelFilter::apply(int64_t timestampMicros, float* values) {
+    if (filterType == Type::None) {
+        return;
+    }
+
+    int64_t gap = timestampMicros - lastTimestamp;
+    if (!primed || gap <= 0 || gap > kMaxGapMicros) {
+        prime(values);
+        lastTimestamp = timestampMicros;
+        return;
+    }
+    lastTimestamp = timestampMicros;
+
+    float dt = static_cast<float>(gap) * 1e-6f;
+    if (filterType == Type::OneEuro) {
+        applyOneEuro(dt, values);
+    } else {
+        applyKalman(dt, values);
+    }
+}
+
+void ChannelFilter::prime(const float* values) {
+    for (size_t i = 0; i < estimate.size(); i++) {
+        // A channel that starts out NaN starts from zero instead
+        estimate[i] = values[i] == values[i] ? values[i] : 0.0f;
+        speed[i] = 0.0f;
+        // Position as uncertain as one measurement, velocity unknown
+        p00[i] = measurementNoise[i];
+        p01[i] = 0.0f;
+        p11[i] = 100.0f * measurementNoise[i];
+    }
+    primed = true;
+}
+
+void ChannelFilter::applyOneEuro(float dt, float* values) {
+    const vfloat rate = vset(1.0f / dt);
+    const vfloat twoPiDt = vset(kTwoPi * dt);
+    const int n = paddedChannelCount();
+    for (int i = 0; i < n; i += kWidth) {
+        vfloat wrap = vloadu(period.data() + i);
+        vfloat halfWrap = vloadu(halfPeriod.data() + i);
+        vfloat previous = vloadu(estimate.data() + i);
+        vfloat previousSpeed = vloadu(speed.data() + i);
+        // Circular channels move to the measurement by the shortest arc
+        vfloat x = vadd(previous, wrapCircular(vsub(vloadu(values + i), previous), wrap, halfWrap));
+
+        // Smoothed speed from the change in estimate, then a speed-dependent cutoff
+        vfloat rawSpeed = vmul(vsub(x, previous), rate);
+        vfloat speedAlpha = lowPassAlpha(vloadu(derivativeCutoff.data() + i), twoPiDt);
+        vfloat smoothedSpeed = flushTiny(vadd(previousSpeed, vmul(speedAlpha, vsub(rawSpeed, previousSpeed))));
+        vfloat cutoff = vadd(vloadu(minCutoff.data() + i), vmul(vloadu(beta.data() + i), vabs(smoothedSpeed)));
+        vfloat filtered = wrapCircular(vadd(previous, vmul(lowPassAlpha(cutoff, twoPiDt), vsub(x, previous))), wrap, halfWrap);
+
+        vmask valid = vnotnan(x);
+        filtered = vselect(valid, filtered, previous);
+        vstoreu(estimate.data() + i, filtered);
+        vstoreu(speed.data() + i, vselect(valid, smoothedSpeed, previousSpeed));
+        vstoreu(values + i, filtered);
+    }
+}
+
+void ChannelFilter::applyKalman(float dt, float* values) {
+    const vfloat vdt = vset(dt);
+    // Discrete white-noise acceleration: Q = q [dt^4/4, dt^3/2; dt^3/2, dt^2]
+    const vfloat q00 = vset(dt * dt * dt * dt * 0.25f);
+    const vfloat q01 = vset(dt * dt * dt * 0.5f);
+    const vfloat q11 = vset(dt * dt);
+    const vfloat one = vset(1.0f);
+    const int n = paddedChannelCount();
+    for (int i = 0; i < n; i += kWidth) {
+        vfloat q = vloadu(processNoise.data() + i);
+        vfloat x = vloadu(values + i);
+        vfloat wrap = vloadu(period.data() + i);
+        vfloat halfWrap = vloadu(halfPeriod.data() + i);
+
+        // Predict
+        vfloat v = vloadu(speed.data() + i);
+        vfloat p = wrapCircular(vadd(vloadu(estimate.data() + i), vmul(v, vdt)), wrap, halfWrap);
+        vfloat c11 = vloadu(p11.data() + i);
+        vfloat c01 = vloadu(p01.data() + i);
+        vfloat c00 = vloadu(p00.data() + i);
+        c00 = vadd(vadd(c00, vmul(vdt, vadd(vadd(c01, c01), vmul(vdt, c11)))), vmul(q, q00));
+        c01 = vadd(vadd(c01, vmul(vdt, c11)), vmul(q, q01));
+        c11 = vadd(c11, vmul(q, q11));
+
+        // Update with the measured position
+        vfloat innovation = wrapCircular(vsub(x, p), wrap, halfWrap);
+        vfloat s = vadd(c00, vloadu(measurementNoise.data() + i));
+        vfloat k0 = vdiv(c00, s);
+        vfloat k1 = vdiv(c01, s);
+        vfloat updatedP = wrapCircular(vadd(p, vmul(k0, innovation)), wrap, halfWrap);
+        vfloat updatedV = flushTiny(vadd(v, vmul(k1, innovation)));
+        vfloat updated11 = vsub(c11, vmul(k1, c01));
+        vfloat updated01 = vmul(vsub(one, k0), c01);
+        vfloat updated00 = vmul(vsub(one, k0), c00);
+
+        // A NaN measurement keeps the prediction
+        vmask valid = vnotnan(x);
+        p = vselect(valid, updatedP, p);
+        vstoreu(estimate.data() + i, p);
+        vstoreu(speed.data() + i, vselect(valid, updatedV, v));
+        vstoreu(p00.data() + i, vselect(valid, updated00, c00));
+        vstoreu(p01.data() + i, vselect(valid, updated01, c01));
+        vstoreu(p11.data() + i, vselect(valid, updated11, c11));
+        vstoreu(values + i, p);
+    }
+}
+
+ChannelFilter::Type ChannelFilter::parseType(const std::string& name) {
+    if (name == "none") {
+        return Type::None;
+    }
+    if (name == "one-euro") {
+        return Type::OneEuro;
+    }
+    if (name == "kalman") {
+        return Type::Kalman;
+    }
+    throw std::invalid_argument("Unknown filter: " + name);
+}
+
+const char* ChannelFilter::typeName(Type type) {
+    switch (type) {
+        case Type::OneEuro: return "one-euro";
+        case Type::Kalman: return "kalman";
+        default: return "none";
+    }
+}
+
+// end of ChannelFilter.cpp //
@@ -0,0 +1,93 @@
+//
+//  ChannelFilter.hpp
+//  LeapTracker
+//
+//  Smoothing for a fixed set of output channels, run over all channels at
+//  once. State and parameters are kept per channel in structure-of-arrays
+//  form, so one frame is a handful of vector passes regardless of the
+//  filter type. Two filters are available:
+//
+//  - One-Euro (Casiez et al. 2012): a low-pass filter whose cutoff rises
+//    with speed, so slow movement is smoothed and fast movement is not lagged.
+//  - Constant-velocity Kalman: position and velocity per channel with white
+//    acceleration noise.
+//
+//  NaN inputs leave a channel's estimate unchanged, and a gap longer than
+//  kMaxGapMicros (e.g. the hand left the field of view) restarts every
+//  channel from its raw value.
+//
+//  Channels with a period, such as angles in -180..180 degrees, are
+//  filtered as circular values: each measurement is taken as the shortest
+//  arc from the estimate, and the estimate is wrapped back into range. A
+//  reading that flips from +179 to -179 is then a 2 degree step rather
+//  than a swing through 0.
+//
+#ifndef ChannelFilter_hpp
+#define ChannelFilter_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ChannelFilter {
+public:
+    enum class Type {
+        None,
+        OneEuro,
+        Kalman
+    };
+
+    struct Parameters {
+        // One-Euro
+        float minCutoff = 1.0f;          // Hz, cutoff when the channel is still
+        float beta = 0.0f;               // cutoff increase in Hz per unit/s of speed
+        float derivativeCutoff = 1.0f;   // Hz, smoothing of the speed estimate
+        // Kalman
+        float processNoise = 1.0f;       // acceleration variance, (units/s^2)^2
+        float measurementNoise = 1.0f;   // units^2
+        // Circular channels: values repeat every period units, centred on 0; 0 for linear channels
+        float period = 0.0f;
+    };
+
+    static const int64_t kMaxGapMicros = 250000;
+
+    ChannelFilter(Type type, int channelCount);
+
+    Type type() const { return filterType; }
+    int channelCount() const { return channels; }
+    // Channels rounded up to whole vectors; arrays passed to apply() must be this long
+    int paddedChannelCount() const { return static_cast<int>(minCutoff.size()); }
+
+    void setParameters(int channel, const Parameters& parameters);
+
+    // Replaces values[0..paddedChannelCount()) with their filtered estimates.
+    // timestampMicros is the frame's capture time.
+    void apply(int64_t timestampMicros, float* values);
+    void reset() { primed = false; }
+
+    static Type parseType(const std::string& name);
+    static const char* typeName(Type type);
+
+private:
+    Type filterType;
+    int channels;
+    bool primed;
+    int64_t lastTimestamp;
+
+    // Per-channel parameters
+    std::vector<float> minCutoff, beta, derivativeCutoff;
+    std::vector<float> processNoise, measurementNoise;
+    // Period and half period; the half period is infinite for linear channels, which never wrap
+    std::vector<float> period, halfPeriod;
+
+    // Per-channel state: estimate and speed (One-Euro: smoothed speed), plus
+    // the Kalman covariance
+    std::vector<float> estimate, speed;
+    std::vector<float> p00, p01, p11;
+
+    void prime(const float* values);
+    void applyOneEuro(float dt, float* values);
+    void applyKalman(float dt, float* values);
+};
+
+#endif /* ChannelFilter_hpp */
@@ -0,0 +1,179 @@
+//
+//  ConsoleDashboard.cpp
+//  LeapTracker
+//
+#include "ConsoleDashboard.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+// Appends one line; on a terminal each line also clears what was drawn under it before
+void appendLine(std::string& view, bool terminal, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+void appendLine(std::string& view, bool terminal, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    view.append(line, static_cast<size_t>(std::min<int>(std::max(length, 0), sizeof(line) - 1)));
+    if (terminal) {
+        view += "\x1b[K";
+    }
+    view += '\n';
+}
+
+void appendWriter(std::string& view, const char* name, const AsyncFileWriter::Stats& stats) {
+    char text[128];
+    int length = snprintf(text, sizeof(text), "   %s %.1f KB pending, lag %.1f ms", name, stats.pendingBytes / 1024.0,
+                          stats.lagMicros / 1000.0);
+    view.append(text, static_cast<size_t>(std::max(length, 0)));
+    if (stats.writeErrors > 0 || stats.journalOverruns > 0) {
+        length = snprintf(text, sizeof(text), " (%llu errors, %llu journal overruns)",
+                          static_cast<unsigned long long>(stats.writeErrors), static_cast<unsigned long long>(stats.journalOverruns));
+        view.append(text, static_cast<size_t>(std::max(length, 0)));
+    }
+}
+
+}  // namespace
+
+DashboardFeed::DashboardFeed() : handsPresent(0) {
+    for (auto& hand : metrics) {
+        for (auto& value : hand) {
+            value.store(0.0f, std::memory_order_relaxed);
+        }
+    }
+}
+
+void DashboardFeed::publishMetrics(int slot, const float* values, size_t count) {
+    count = std::min(count, kMetricCount);
+    for (size_t m = 0; m < count; m++) {
+        metrics[slot][m].store(values[m], std::memory_order_relaxed);
+    }
+}
+
+ConsoleDashboard::ConsoleDashboard(std::chrono::milliseconds interval)
+    : interval(interval), terminal(isatty(STDOUT_FILENO) != 0), linesDrawn(0), stopping(false) {}
+
+ConsoleDashboard::~ConsoleDashboard() {
+    stop();
+}
+
+void ConsoleDashboard::start(const std::vector<Source>& dashboardSources) {
+    stop();
+    sources = dashboardSources;
+    previousFrames.assign(sources.size(), 0);
+    for (size_t i = 0; i < sources.size(); i++) {
+        previousFrames[i] = sources[i].metrics->frames();
+    }
+    started = previousRefresh = Clock::now();
+    linesDrawn = 0;
+    stopping = false;
+    thread = std::thread(&ConsoleDashboard::run, this);
+}
+
+void ConsoleDashboard::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable()) {
+            return;
+        }
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void ConsoleDashboard::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        wake.wait_for(lock, interval, [this] { return stopping; });
+        lock.unlock();
+        refresh();
+        lock.lock();
+    }
+}
+
+void ConsoleDashboard::refresh() {
+    Clock::time_point now = Clock::now();
+    view.clear();
+    if (terminal && linesDrawn > 0) {
+        // Back to the top of the previous view, which is then drawn over
+        char up[16];
+        int length = snprintf(up, sizeof(up), "\x1b[%dA\r", linesDrawn);
+        view.append(up, static_cast<size_t>(length));
+    }
+    size_t start = view.size();
+    render(now);
+    linesDrawn = static_cast<int>(std::count(view.begin() + static_cast<std::ptrdiff_t>(start), view.end(), '\n'));
+    if (terminal) {
+        view += "\x1b[J";
+    } else {
+        view += '\n';
+    }
+    std::cout.write(view.data(), static_cast<std::streamsize>(view.size()));
+    std::cout.flush();
+    previousRefresh = now;
+}
+
+void ConsoleDashboard::render(Clock::time_point now) {
+    using std::chrono::duration;
+    double elapsed = duration<double>(now - previousRefresh).count();
+    long seconds = static_cast<long>(duration<double>(now - started).count());
+    appendLine(view, terminal, "LeapTracker  %02ld:%02ld:%02ld  (latency since start, p50/p99 us)", seconds / 3600, seconds / 60 % 60,
+               seconds % 60);
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        const Source& source = sources[i];
+        uint64_t frames = source.metrics->frames();
+        double rate = elapsed > 0 ? (frames - previousFrames[i]) / elapsed : 0.0;
+        previousFrames[i] = frames;
+        uint32_t hands = source.feed->handsPresent.load(std::memory_order_relaxed);
+
+        std::string line;
+        char text[160];
+        int length = snprintf(text, sizeof(text), "  %6.1f fps   hands %-10s   ring %zu/%zu, %llu overflows", rate,
+                              hands == 0 ? "none" : hands == 1 ? "left" : hands == 2 ? "right" : "left+right",
+                              source.frameRing->size(), source.frameRing->capacity(),
+                              static_cast<unsigned long long>(source.frameRing->overflowCount()));
+        line.append(text, static_cast<size_t>(std::max(length, 0)));
+        if (source.csvLog) {
+            appendWriter(line, "csv", source.csvLog->stats());
+        }
+        if (source.binaryLog) {
+            appendWriter(line, "binary", source.binaryLog->stats());
+        }
+        appendLine(view, terminal, "%s", source.label.c_str());
+        appendLine(view, terminal, "%s", line.c_str());
+
+        for (int slot = 0; slot < kHandSlots; slot++) {
+            line.clear();
+            if (hands & (1u << slot)) {
+                for (size_t m = 0; m < source.pipeline->metricCount; m++) {
+                    length = snprintf(text, sizeof(text), "  %s %.3f", metricInfo(source.pipeline->metrics[m]).jsonKey,
+                                      source.feed->metrics[slot][m].load(std::memory_order_relaxed));
+                    line.append(text, static_cast<size_t>(std::max(length, 0)));
+                }
+            } else {
+                line = "  -";
+            }
+            appendLine(view, terminal, "  %-5s%s", handSlotName(slot), line.c_str());
+        }
+
+        line.clear();
+        for (int i = 0; i < TrackerMetrics::StageCount; i++) {
+            TrackerMetrics::Stage stage = static_cast<TrackerMetrics::Stage>(i);
+            const LatencyHistogram& h = source.metrics->histogram(stage);
+            length = snprintf(text, sizeof(text), "  %s %.0f/%.0f", TrackerMetrics::stageName(stage), h.percentile(0.50) / 1000.0,
+                              h.percentile(0.99) / 1000.0);
+            line.append(text, static_cast<size_t>(std::max(length, 0)));
+        }
+        appendLine(view, terminal, "  latency%s", line.c_str());
+    }
+}
+
+// end of ConsoleDashboard.cpp //
@@ -0,0 +1,89 @@
+//
+//  ConsoleDashboard.hpp
+//  LeapTracker
+//
+//  Terminal status view (--dashboard). Processing threads publish the live
+//  hand state into their session's DashboardFeed with relaxed atomic stores,
+//  and the dashboard's own thread renders every session a few times a second:
+//  frame rate, hands present, current metric values, frame ring and log
+//  writer backlog, and latency percentiles. On a terminal the view is redrawn
+//  in place; when stdout is redirected each refresh is appended as plain
+//  text. Nothing is printed per frame, so the console never slows processing.
+//
+#ifndef ConsoleDashboard_hpp
+#define ConsoleDashboard_hpp
+
+#include "AsyncFileWriter.hpp"
+#include "ExerciseMetrics.hpp"
+#include "FrameRing.hpp"
+#include "HandKernel.hpp"
+#include "SessionFile.hpp"
+#include "TrackerMetrics.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Written by one processing thread, read by the dashboard
+struct DashboardFeed {
+    std::atomic<uint32_t> handsPresent;                     // bit handSlot() per hand in the last frame
+    std::atomic<float> metrics[kHandSlots][kMetricCount];   // pipeline order, last value sent per hand
+
+    DashboardFeed();
+
+    void publishHands(uint32_t mask) { handsPresent.store(mask, std::memory_order_relaxed); }
+    void publishMetrics(int slot, const float* values, size_t count);
+};
+
+class ConsoleDashboard {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // One session's view; the pointers must outlive stop()
+    struct Source {
+        std::string label;
+        const DashboardFeed* feed;
+        const TrackerMetrics* metrics;
+        const FrameRing* frameRing;
+        const ExercisePipeline* pipeline;
+        const AsyncFileWriter* csvLog;          // null when not written
+        const SessionFileWriter* binaryLog;     // null when not written
+    };
+
+    explicit ConsoleDashboard(std::chrono::milliseconds interval);
+    ~ConsoleDashboard();
+
+    ConsoleDashboard(const ConsoleDashboard&) = delete;
+    ConsoleDashboard& operator=(const ConsoleDashboard&) = delete;
+
+    void start(const std::vector<Source>& sources);
+    // Draws the final state once more and joins the thread
+    void stop();
+
+private:
+    std::chrono::milliseconds interval;
+    std::vector<Source> sources;
+    bool terminal;
+
+    // Dashboard thread only: frame counts at the previous refresh, for the rates
+    std::vector<uint64_t> previousFrames;
+    Clock::time_point previousRefresh;
+    Clock::time_point started;
+    int linesDrawn;
+    std::string view;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    std::thread thread;
+
+    void run();
+    void refresh();
+    void render(Clock::time_point now);
+};
+
+#endif /* ConsoleDashboard_hpp */
@@ -0,0 +1,62 @@
+//
+//  DeviceClock.cpp
+//  LeapTracker
+//
+#include "DeviceClock.hpp"
+#include <chrono>
+
+namespace {
+
+int64_t epochMicrosNow() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+DeviceClock::DeviceClock(int64_t refreshIntervalMicros)
+    : rebaser(nullptr), refreshInterval(refreshIntervalMicros), lastRefresh(0),
+      offsetMicros(0), utcOffsetSeconds(0), calibrated(false)
+{
+    if (LeapCreateClockRebaser(&rebaser) != eLeapRS_Success) {
+        rebaser = nullptr;
+    }
+}
+
+DeviceClock::~DeviceClock() {
+    if (rebaser) {
+        LeapDestroyClockRebaser(rebaser);
+    }
+}
+
+void DeviceClock::refresh() {
+    int64_t userNow = epochMicrosNow();
+    int64_t leapNow = LeapGetNow();
+    int64_t leapAtUser = leapNow;
+
+    // The rebaser smooths the user->LeapC mapping across updates; invert it at "now"
+    if (rebaser && LeapUpdateRebase(rebaser, userNow, leapNow) == eLeapRS_Success) {
+        if (LeapRebaseClock(rebaser, userNow, &leapAtUser) != eLeapRS_Success) {
+            leapAtUser = leapNow;
+        }
+    }
+    offsetMicros = userNow - leapAtUser;
+    lastRefresh = leapNow;
+
+    // localtime_r is only called here, not per frame
+    utcOffsetSeconds = localUtcOffsetSeconds(userNow);
+    calibrated = true;
+}
+
+int64_t DeviceClock::toEpochMicros(int64_t leapTimestamp) {
+    if (!calibrated || leapTimestamp - lastRefresh > refreshInterval) {
+        refresh();
+    }
+    return leapTimestamp + offsetMicros;
+}
+
+size_t DeviceClock::format(int64_t epochMicros, Format format, char* buffer) const {
+    return formatTimestamp(epochMicros, format, utcOffsetSeconds, buffer);
+}
+
+// end of DeviceClock.cpp //
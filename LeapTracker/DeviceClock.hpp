@@ -0,0 +1,45 @@
+//
+//  DeviceClock.hpp
+//  LeapTracker
+//
+//  Maps LeapC frame timestamps (LeapGetNow() microseconds) onto wall-clock
+//  time. The offset between the two clocks comes from a LeapC clock rebaser
+//  and is refreshed periodically rather than per frame; the text itself comes
+//  from TimestampFormat, so stamping a frame never allocates.
+//
+#ifndef DeviceClock_hpp
+#define DeviceClock_hpp
+
+#include "LeapC.h"
+#include "TimestampFormat.hpp"
+#include <cstddef>
+#include <cstdint>
+
+class DeviceClock {
+public:
+    typedef TimestampFormat Format;
+
+    explicit DeviceClock(int64_t refreshIntervalMicros = 1000000);
+    ~DeviceClock();
+
+    DeviceClock(const DeviceClock&) = delete;
+    DeviceClock& operator=(const DeviceClock&) = delete;
+
+    // Microseconds since the Unix epoch for a LEAP_FRAME_HEADER timestamp
+    int64_t toEpochMicros(int64_t leapTimestamp);
+
+    // Writes the timestamp in this machine's time zone; see formatTimestamp
+    size_t format(int64_t epochMicros, Format format, char* buffer) const;
+
+private:
+    LEAP_CLOCK_REBASER rebaser;
+    int64_t refreshInterval;
+    int64_t lastRefresh;       // LeapC time of the last refresh
+    int64_t offsetMicros;      // epoch microseconds minus LeapC microseconds
+    int64_t utcOffsetSeconds;  // local time zone offset, refreshed with the rebase
+    bool calibrated;
+
+    void refresh();
+};
+
+#endif /* DeviceClock_hpp */
@@ -0,0 +1,178 @@
+//
+//  EventDetector.cpp
+//  LeapTracker
+//
+#include "EventDetector.hpp"
+#include <cmath>
+
+namespace {
+
+const int64_t kDebounce = 40000;
+
+EventRule channelRule(const char* name, int channel, bool below, float enter, float exit) {
+    return { name, channel, MetricId::Count, below, enter, exit, kDebounce };
+}
+
+EventRule metricRule(const char* name, MetricId metric, bool below, float enter, float exit) {
+    return { name, -1, metric, below, enter, exit, kDebounce };
+}
+
+// Distances in mm, metrics 0..1
+const EventRule kPinch = channelRule("pinch", HandChannels::ThumbDistances, true, 25.0f, 35.0f);
+const EventRule kThumbTouches[4] = {
+    channelRule("thumb_index_touch", HandChannels::ThumbDistances, true, 25.0f, 35.0f),
+    channelRule("thumb_middle_touch", HandChannels::ThumbDistances + 1, true, 25.0f, 35.0f),
+    channelRule("thumb_ring_touch", HandChannels::ThumbDistances + 2, true, 25.0f, 35.0f),
+    channelRule("thumb_pinky_touch", HandChannels::ThumbDistances + 3, true, 25.0f, 35.0f)
+};
+const EventRule kFist = metricRule("fist", MetricId::MakeAFist, false, 0.8f, 0.6f);
+const EventRule kSupination = metricRule("supination", MetricId::PronationSupination, false, 0.8f, 0.65f);
+const EventRule kPronation = metricRule("pronation", MetricId::PronationSupination, true, 0.2f, 0.35f);
+const EventRule kWristExtension = metricRule("wrist_extension", MetricId::WristAROM, false, 0.75f, 0.6f);
+const EventRule kWristFlexion = metricRule("wrist_flexion", MetricId::WristAROM, true, 0.25f, 0.4f);
+
+struct ExerciseRules {
+    const char* exerciseName;
+    std::vector<EventRule> rules;
+};
+
+// Exercises not listed here have no events
+const ExerciseRules kExerciseRules[] = {
+    { "thumb_index_pinch", { kPinch } },
+    { "pincer_grip", { kPinch } },
+    { "thumb_touch", { kThumbTouches[0], kThumbTouches[1], kThumbTouches[2], kThumbTouches[3] } },
+    { "make_a_fist", { kFist } },
+    { "pronation_supination", { kSupination, kPronation } },
+    { "wrist_arom", { kWristExtension, kWristFlexion } }
+};
+
+// Time at which the value crossed threshold between two frames
+int64_t crossingTime(int64_t t0, float v0, int64_t t1, float v1, float threshold) {
+    if (v1 == v0) {
+        return t1;
+    }
+    double fraction = (threshold - v0) / static_cast<double>(v1 - v0);
+    fraction = std::fmin(1.0, std::fmax(0.0, fraction));
+    return t0 + static_cast<int64_t>(std::llround(fraction * static_cast<double>(t1 - t0)));
+}
+
+}  // namespace
+
+const char* DetectedEvent::kindName(Kind kind) {
+    switch (kind) {
+        case Start: return "start";
+        case End: return "end";
+        case Peak: return "peak";
+        case Rep: return "rep";
+        default: return "unknown";
+    }
+}
+
+EventDetector::EventDetector(const std::string& exerciseName, const ExercisePipeline& pipeline) {
+    for (const ExerciseRules& entry : kExerciseRules) {
+        if (exerciseName != entry.exerciseName) {
+            continue;
+        }
+        for (EventRule rule : entry.rules) {
+            if (rule.channel < 0) {
+                // Metrics sit in the channels in pipeline order
+                for (size_t m = 0; m < pipeline.metricCount; m++) {
+                    if (pipeline.metrics[m] == rule.metric) {
+                        rule.channel = HandChannels::Metrics + static_cast<int>(m);
+                    }
+                }
+                if (rule.channel < 0) {
+                    continue;
+                }
+            }
+            rules.push_back(rule);
+        }
+    }
+    for (auto& handStates : states) {
+        handStates.resize(rules.size());
+    }
+}
+
+void EventDetector::update(eLeapHandType hand, int64_t timestamp, const HandChannels& channels, std::vector<DetectedEvent>& out) {
+    std::vector<RuleState>& handStates = states[handSlot(hand)];
+    for (size_t r = 0; r < rules.size(); r++) {
+        updateRule(rules[r], handStates[r], hand, timestamp, channels[rules[r].channel], out);
+    }
+}
+
+void EventDetector::updateRule(const EventRule& rule, RuleState& state, eLeapHandType hand, int64_t timestamp, float value,
+                               std::vector<DetectedEvent>& out) {
+    if (std::isnan(value)) {
+        return;
+    }
+
+    // Tracking lost mid-movement: close it where it was last seen, without counting a repetition
+    if (state.seen && (timestamp <= state.lastTimestamp || timestamp - state.lastTimestamp > kMaxGapMicros)) {
+        if (state.phase == Active || state.phase == Leaving) {
+            out.push_back({ rule.name, DetectedEvent::End, hand, state.lastTimestamp, state.lastValue, state.repetitions + 1 });
+        }
+        state.phase = Idle;
+        state.seen = false;
+    }
+    if (!state.seen) {
+        state.seen = true;
+        state.lastTimestamp = timestamp;
+        state.lastValue = value;
+        return;
+    }
+
+    bool pastEnter = rule.below ? value < rule.enterThreshold : value > rule.enterThreshold;
+    bool pastExit = rule.below ? value > rule.exitThreshold : value < rule.exitThreshold;
+    bool newPeak = rule.below ? value < state.peak : value > state.peak;
+
+    switch (state.phase) {
+        case Idle:
+            if (pastEnter) {
+                state.phase = Entering;
+                state.crossingTimestamp = crossingTime(state.lastTimestamp, state.lastValue, timestamp, value, rule.enterThreshold);
+                state.peak = value;
+                state.peakTimestamp = timestamp;
+            }
+            break;
+        case Entering:
+            if (!pastEnter) {
+                state.phase = Idle;
+            } else if (newPeak) {
+                state.peak = value;
+                state.peakTimestamp = timestamp;
+            }
+            break;
+        case Active:
+        case Leaving:
+            if (newPeak) {
+                state.peak = value;
+                state.peakTimestamp = timestamp;
+            }
+            if (state.phase == Active && pastExit) {
+                state.phase = Leaving;
+                state.crossingTimestamp = crossingTime(state.lastTimestamp, state.lastValue, timestamp, value, rule.exitThreshold);
+            } else if (state.phase == Leaving && !pastExit) {
+                state.phase = Active;
+            }
+            break;
+    }
+
+    // Confirm a crossing once it has held for the debounce time
+    if (state.phase == Entering && timestamp - state.crossingTimestamp >= rule.debounceMicros) {
+        state.phase = Active;
+        state.startTimestamp = state.crossingTimestamp;
+        out.push_back({ rule.name, DetectedEvent::Start, hand, state.crossingTimestamp, rule.enterThreshold, state.repetitions + 1 });
+    } else if (state.phase == Leaving && timestamp - state.crossingTimestamp >= rule.debounceMicros) {
+        state.phase = Idle;
+        state.repetitions++;
+        float duration = static_cast<float>(state.crossingTimestamp - state.startTimestamp) * 1e-6f;
+        out.push_back({ rule.name, DetectedEvent::End, hand, state.crossingTimestamp, rule.exitThreshold, state.repetitions });
+        out.push_back({ rule.name, DetectedEvent::Peak, hand, state.peakTimestamp, state.peak, state.repetitions });
+        out.push_back({ rule.name, DetectedEvent::Rep, hand, state.crossingTimestamp, duration, state.repetitions });
+    }
+
+    state.lastTimestamp = timestamp;
+    state.lastValue = value;
+}
+
+// end of EventDetector.cpp //
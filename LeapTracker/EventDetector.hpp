@@ -0,0 +1,94 @@
+//
+//  EventDetector.hpp
+//  LeapTracker
+//
+//  Discrete exercise events (pinch start/end, fist peak, completed
+//  repetitions) detected from the per-frame channels, so event consumers
+//  need not threshold the full frame stream themselves. Each rule watches one
+//  channel with two thresholds (hysteresis): a movement starts when the value
+//  passes enterThreshold and ends when it passes back beyond exitThreshold.
+//  A crossing only counts once the value has stayed past the threshold for
+//  debounceMicros, so single-frame spikes produce nothing; events are then
+//  stamped with the crossing time, interpolated between the two frames that
+//  straddle it.
+//
+//  Rules per exercise are listed in kExerciseRules in EventDetector.cpp.
+//
+#ifndef EventDetector_hpp
+#define EventDetector_hpp
+
+#include "LeapC.h"
+#include "HandChannels.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct EventRule {
+    const char* name;          // e.g. "pinch"; events go to /leap/event/<name>_<kind>
+    int channel;               // HandChannels index, or -1 to use metric
+    MetricId metric;           // used when channel is -1; the rule is dropped if the exercise lacks it
+    bool below;                // active while the value is below enterThreshold (distances) rather than above
+    float enterThreshold;
+    float exitThreshold;       // beyond enterThreshold on the inactive side
+    int64_t debounceMicros;
+};
+
+struct DetectedEvent {
+    enum Kind {
+        Start,      // value passed enterThreshold
+        End,        // value passed back beyond exitThreshold, or tracking was lost
+        Peak,       // the extreme value of the movement, stamped when it was reached
+        Rep         // a completed start/end cycle; value is its duration in seconds
+    };
+
+    const char* rule;
+    Kind kind;
+    eLeapHandType hand;
+    int64_t timestamp;         // LeapC microseconds
+    float value;
+    uint32_t repetition;       // the movement's number within the session, from 1
+
+    static const char* kindName(Kind kind);
+};
+
+class EventDetector {
+public:
+    // A hand unseen for longer than this ends any movement in progress
+    static const int64_t kMaxGapMicros = 250000;
+
+    EventDetector(const std::string& exerciseName, const ExercisePipeline& pipeline);
+
+    bool empty() const { return rules.empty(); }
+
+    // Processing thread, once per hand per frame. Appends the frame's events to out.
+    void update(eLeapHandType hand, int64_t timestamp, const HandChannels& channels, std::vector<DetectedEvent>& out);
+
+private:
+    enum Phase {
+        Idle,
+        Entering,   // past enterThreshold, waiting out the debounce
+        Active,
+        Leaving     // past exitThreshold, waiting out the debounce
+    };
+
+    struct RuleState {
+        Phase phase = Idle;
+        bool seen = false;
+        int64_t lastTimestamp = 0;
+        float lastValue = 0;
+        int64_t crossingTimestamp = 0;  // of the pending crossing
+        int64_t startTimestamp = 0;
+        float peak = 0;
+        int64_t peakTimestamp = 0;
+        uint32_t repetitions = 0;
+    };
+
+    std::vector<EventRule> rules;
+    // Indexed by handSlot(), then rule
+    std::vector<RuleState> states[kHandSlots];
+
+    void updateRule(const EventRule& rule, RuleState& state, eLeapHandType hand, int64_t timestamp, float value,
+                    std::vector<DetectedEvent>& out);
+};
+
+#endif /* EventDetector_hpp */
@@ -0,0 +1,112 @@
+//
+//  ExerciseMetrics.cpp
+//  LeapTracker
+//
+#include "ExerciseMetrics.hpp"
+#include "FastMath.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// Exercise names match the game's exercise selector and the analysis scripts
+constexpr ExercisePipeline kExercisePipelines[] = {
+    makeExercisePipeline<>("thumb_index_pinch"),
+    makeExercisePipeline<>("pincer_grip"),
+    makeExercisePipeline<>("thumb_touch"),
+    makeExercisePipeline<MetricId::MakeAFist>("make_a_fist"),
+    makeExercisePipeline<MetricId::PronationSupination>("pronation_supination"),
+    makeExercisePipeline<MetricId::WristAROM>("wrist_arom")
+};
+
+constexpr ExercisePipeline kAllMetrics =
+    makeExercisePipeline<MetricId::MakeAFist, MetricId::PronationSupination, MetricId::WristAROM>("");
+
+}  // namespace
+
+const ExercisePipeline& exercisePipelineFor(const std::string& exerciseName) {
+    for (const ExercisePipeline& pipeline : kExercisePipelines) {
+        if (exerciseName == pipeline.exerciseName) {
+            return pipeline;
+        }
+    }
+    std::cerr << "Unknown exercise \"" << exerciseName << "\", computing all metrics" << std::endl;
+    return kAllMetrics;
+}
+
+MetricScale MetricScale::fromRange(MetricId id, float low, float high) {
+    MetricScale s;
+    s.scale = 1.0f / (high - low);
+    s.offset = -low * s.scale;
+    s.min = metricInfo(id).clamped ? 0.0f : -std::numeric_limits<float>::infinity();
+    s.max = metricInfo(id).clamped ? 1.0f : std::numeric_limits<float>::infinity();
+    return s;
+}
+
+const MetricCalibration& MetricCalibration::defaults() {
+    static const MetricCalibration calibration = [] {
+        MetricCalibration c;
+        for (size_t m = 0; m < kMetricCount; m++) {
+            MetricId id = static_cast<MetricId>(m);
+            c[id] = MetricScale::fromRange(id, metricInfo(id).defaultLow, metricInfo(id).defaultHigh);
+        }
+        return c;
+    }();
+    return calibration;
+}
+
+const MetricCalibration& MetricCalibration::identity() {
+    static const MetricCalibration calibration = [] {
+        MetricCalibration c;
+        for (MetricScale& s : c.metrics) {
+            s = { 1.0f, 0.0f, -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+        }
+        return c;
+    }();
+    return calibration;
+}
+
+float calculateMakeAFistRaw(const HandGeometry& geometry) {
+    // Open hand is around 50 degrees, a closed fist around 700
+    return geometry.totalFlexion;
+}
+
+float calculatePronationSupinationRaw(const HandGeometry& geometry) {
+    // Use palm normal to determine pronation/supination: -pi/2 is full pronation, pi/2 full supination
+    return Trig::atan2(geometry.palmNormal.y, geometry.palmNormal.x);
+}
+
+float calculateWristAROMRaw(const HandGeometry& geometry) {
+    // Calculate wrist angle relative to forearm, both already unit vectors
+    const LEAP_VECTOR& wristDirection = geometry.armDirection;
+    const LEAP_VECTOR& palmDirection = geometry.palmDirection;
+    
+    float dotProduct = wristDirection.x * palmDirection.x + 
+                       wristDirection.y * palmDirection.y + 
+                       wristDirection.z * palmDirection.z;
+    
+    float angle = Trig::acos(std::max(-1.0f, std::min(1.0f, dotProduct)));
+    
+    // Determine if the bend is upward or downward
+    float upDownFactor = palmDirection.y > 0 ? 1.0f : -1.0f;
+    
+    return angle * upDownFactor;
+}
+
+float calculateMakeAFistMetric(const HandGeometry& geometry, const MetricCalibration& calibration) {
+    return calibration[MetricId::MakeAFist].apply(calculateMakeAFistRaw(geometry));
+}
+
+float calculatePronationSupinationMetric(const HandGeometry& geometry, const MetricCalibration& calibration) {
+    // 0 is full pronation and 1 is full supination
+    return calibration[MetricId::PronationSupination].apply(calculatePronationSupinationRaw(geometry));
+}
+
+float calculateWristAROMMetric(const HandGeometry& geometry, const MetricCalibration& calibration) {
+    // 0.5 is neutral, 1 is max upward bend, and 0 is max downward bend
+    return calibration[MetricId::WristAROM].apply(calculateWristAROMRaw(geometry));
+}
+
+// end of ExerciseMetrics.cpp //
@@ -0,0 +1,139 @@
+//
+//  ExerciseMetrics.hpp
+//  LeapTracker
+//
+//  Registry of exercise metrics and the exercises that use them. Each
+//  exercise resolves at startup to an ExercisePipeline whose compute function
+//  is a MetricSet instantiation, so per frame it evaluates exactly that
+//  exercise's metrics with no lookups or branches. The pipeline's metric ids
+//  give the JSON keys, OSC addresses and CSV columns to emit, in order.
+//
+//  Each metric measures a raw quantity (total flexion, a palm angle) and maps
+//  it to 0..1 with a scale/offset pair from a MetricCalibration: by default
+//  the range in MetricInfo, or a patient's own range from CalibrationCache.
+//
+//  To add a metric: add an id before MetricId::Count, its MetricInfo entry
+//  and a Metric<> specialisation. To add an exercise: add a row to
+//  kExercisePipelines in ExerciseMetrics.cpp.
+//
+#ifndef ExerciseMetrics_hpp
+#define ExerciseMetrics_hpp
+
+#include "HandKernel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
+
+enum class MetricId {
+    MakeAFist,
+    PronationSupination,
+    WristAROM,
+    Count
+};
+
+const size_t kMetricCount = static_cast<size_t>(MetricId::Count);
+
+struct MetricInfo {
+    const char* jsonKey;      // key in the WebSocket "metrics" object
+    const char* oscAddress;
+    const char* csvColumn;
+    float defaultLow;         // raw quantity mapped to 0 without calibration
+    float defaultHigh;        // raw quantity mapped to 1 without calibration
+    bool clamped;             // whether the 0..1 value is clamped to that range
+};
+
+// Indexed by MetricId. Raw quantities: total flexion of the 15 finger joints
+// in degrees; palm normal roll from atan2 in radians; wrist bend in radians,
+// positive upwards.
+constexpr MetricInfo kMetricInfo[kMetricCount] = {
+    { "makeAFist", "/leap/make_a_fist", "Make A Fist", 50.0f, 700.0f, true },
+    { "pronationSupination", "/leap/pronation_supination", "Pronation Supination", -1.57079633f, 1.57079633f, false },
+    { "wristAROM", "/leap/wrist_arom", "Wrist AROM", -1.57079633f, 1.57079633f, true }
+};
+
+constexpr const MetricInfo& metricInfo(MetricId id) { return kMetricInfo[static_cast<size_t>(id)]; }
+
+// value = raw * scale + offset, then clamped to [min, max]
+struct MetricScale {
+    float scale;
+    float offset;
+    float min;
+    float max;
+
+    float apply(float raw) const { return std::min(max, std::max(min, raw * scale + offset)); }
+
+    // Maps low to 0 and high to 1, clamped if the metric is
+    static MetricScale fromRange(MetricId id, float low, float high);
+};
+
+// Scale/offset pairs for every metric of one hand
+struct MetricCalibration {
+    MetricScale metrics[kMetricCount];
+
+    const MetricScale& operator[](MetricId id) const { return metrics[static_cast<size_t>(id)]; }
+    MetricScale& operator[](MetricId id) { return metrics[static_cast<size_t>(id)]; }
+
+    // The ranges in kMetricInfo
+    static const MetricCalibration& defaults();
+    // Scale 1, offset 0, no clamping: metrics come out as their raw quantities
+    static const MetricCalibration& identity();
+};
+
+// Raw quantities behind each metric
+float calculateMakeAFistRaw(const HandGeometry& geometry);
+float calculatePronationSupinationRaw(const HandGeometry& geometry);
+float calculateWristAROMRaw(const HandGeometry& geometry);
+
+// Normalised 0..1 exercise metrics
+float calculateMakeAFistMetric(const HandGeometry& geometry, const MetricCalibration& calibration = MetricCalibration::defaults());
+float calculatePronationSupinationMetric(const HandGeometry& geometry, const MetricCalibration& calibration = MetricCalibration::defaults());
+float calculateWristAROMMetric(const HandGeometry& geometry, const MetricCalibration& calibration = MetricCalibration::defaults());
+
+template <MetricId Id> struct Metric;
+template <> struct Metric<MetricId::MakeAFist> {
+    static float compute(const HandGeometry& geometry, const MetricCalibration& calibration) {
+        return calibration[MetricId::MakeAFist].apply(calculateMakeAFistRaw(geometry));
+    }
+};
+template <> struct Metric<MetricId::PronationSupination> {
+    static float compute(const HandGeometry& geometry, const MetricCalibration& calibration) {
+        return calibration[MetricId::PronationSupination].apply(calculatePronationSupinationRaw(geometry));
+    }
+};
+template <> struct Metric<MetricId::WristAROM> {
+    static float compute(const HandGeometry& geometry, const MetricCalibration& calibration) {
+        return calibration[MetricId::WristAROM].apply(calculateWristAROMRaw(geometry));
+    }
+};
+
+// A fixed list of metrics, computed in order into out[0..size)
+template <MetricId... Ids>
+struct MetricSet {
+    static constexpr size_t size = sizeof...(Ids);
+    static constexpr std::array<MetricId, sizeof...(Ids)> ids = {{ Ids... }};
+
+    static void compute([[maybe_unused]] const HandGeometry& geometry, [[maybe_unused]] const MetricCalibration& calibration,
+                        [[maybe_unused]] float* out) {
+        [[maybe_unused]] size_t i = 0;
+        ((out[i++] = Metric<Ids>::compute(geometry, calibration)), ...);
+    }
+};
+
+struct ExercisePipeline {
+    const char* exerciseName;
+    const MetricId* metrics;
+    size_t metricCount;
+    void (*compute)(const HandGeometry& geometry, const MetricCalibration& calibration, float* out);
+};
+
+template <MetricId... Ids>
+constexpr ExercisePipeline makeExercisePipeline(const char* exerciseName) {
+    return { exerciseName, MetricSet<Ids...>::ids.data(), MetricSet<Ids...>::size, &MetricSet<Ids...>::compute };
+}
+
+// Pipeline for an exercise name as given on the command line; unknown
+// exercises get every metric
+const ExercisePipeline& exercisePipelineFor(const std::string& exerciseName);
+
+#endif /* ExerciseMetrics_hpp */
@@ -0,0 +1,93 @@
+//
+//  FastMath.hpp
+//  LeapTracker
+//
+//  Inverse trigonometric functions for the per-frame angle code, behind a
+//  compile-time policy. LibmTrig calls the C library in double precision as
+//  the tracker always has; FastTrig uses short polynomials (Abramowitz and
+//  Stegun 4.4.45 and 4.4.47) evaluated in float. Trig is the policy the
+//  tracker uses: FastTrig when built with LEAPTRACKER_FAST_MATH, LibmTrig
+//  otherwise. FastMathBenchmark checks the error bounds below against libm.
+//
+#ifndef FastMath_hpp
+#define FastMath_hpp
+
+#include <cmath>
+
+namespace fastmath {
+
+const float kPi = 3.14159265358979f;
+const float kHalfPi = 1.57079632679490f;
+
+// acos(x) ~ sqrt(1 - x) * (a0 + a1 x + a2 x^2 + a3 x^3) for 0 <= x <= 1
+const float kAcos0 = 1.5707288f;
+const float kAcos1 = -0.2121144f;
+const float kAcos2 = 0.0742610f;
+const float kAcos3 = -0.0187293f;
+
+// atan(x) ~ x (b1 + b3 x^2 + b5 x^4 + b7 x^6 + b9 x^8) for -1 <= x <= 1
+const float kAtan1 = 0.9998660f;
+const float kAtan3 = -0.3302995f;
+const float kAtan5 = 0.1801410f;
+const float kAtan7 = -0.0851330f;
+const float kAtan9 = 0.0208351f;
+
+// Maximum absolute error against libm over the whole domain, in degrees
+const double kAcosMaxErrorDegrees = 0.005;
+const double kAsinMaxErrorDegrees = 0.005;
+const double kAtan2MaxErrorDegrees = 0.001;
+
+// Arguments outside [-1, 1] give NaN, as std::acos does
+inline float acos(float x) {
+    float ax = std::fabs(x);
+    float r = std::sqrt(1.0f - ax) * (kAcos0 + ax * (kAcos1 + ax * (kAcos2 + ax * kAcos3)));
+    return x < 0.0f ? kPi - r : r;
+}
+
+inline float asin(float x) {
+    return kHalfPi - fastmath::acos(x);
+}
+
+inline float atan2(float y, float x) {
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float largest = ax > ay ? ax : ay;
+    if (largest == 0.0f) {
+        return 0.0f;
+    }
+    // Reduce to atan of a ratio in [0, 1], then unfold the octant
+    float t = (ax > ay ? ay : ax) / largest;
+    float t2 = t * t;
+    float r = t * (kAtan1 + t2 * (kAtan3 + t2 * (kAtan5 + t2 * (kAtan7 + t2 * kAtan9))));
+    if (ay > ax) {
+        r = kHalfPi - r;
+    }
+    if (x < 0.0f) {
+        r = kPi - r;
+    }
+    return y < 0.0f ? -r : r;
+}
+
+}  // namespace fastmath
+
+struct LibmTrig {
+    static const char* name() { return "libm"; }
+    static float acos(float x) { return static_cast<float>(std::acos(static_cast<double>(x))); }
+    static float asin(float x) { return static_cast<float>(std::asin(static_cast<double>(x))); }
+    static float atan2(float y, float x) { return static_cast<float>(std::atan2(static_cast<double>(y), static_cast<double>(x))); }
+};
+
+struct FastTrig {
+    static const char* name() { return "fast"; }
+    static float acos(float x) { return fastmath::acos(x); }
+    static float asin(float x) { return fastmath::asin(x); }
+    static float atan2(float y, float x) { return fastmath::atan2(y, x); }
+};
+
+#if LEAPTRACKER_FAST_MATH
+typedef FastTrig Trig;
+#else
+typedef LibmTrig Trig;
+#endif
+
+#endif /* FastMath_hpp */
@@ -0,0 +1,42 @@
+//
+//  FrameRecording.cpp
+//  LeapTracker
+//
+#include "FrameRecording.hpp"
+
+FrameRecorder::FrameRecorder() : frames(0) {}
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+bool FrameRecorder::open(const std::string& path) {
+    file.open(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    FrameRecordingHeader header = { FRAME_RECORDING_MAGIC, FRAME_RECORDING_VERSION, sizeof(LEAP_HAND), 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    frames = 0;
+    return true;
+}
+
+void FrameRecorder::write(const LEAP_TRACKING_EVENT* frame) {
+    if (!file.is_open()) {
+        return;
+    }
+
+    FrameRecordingEntry entry = { frame->info.frame_id, frame->info.timestamp, frame->tracking_frame_id, frame->framerate, frame->nHands };
+    file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    file.write(reinterpret_cast<const char*>(frame->pHands), frame->nHands * sizeof(LEAP_HAND));
+    frames++;
+}
+
+void FrameRecorder::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+}
+
+// end of FrameRecording.cpp //
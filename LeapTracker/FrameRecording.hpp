@@ -0,0 +1,56 @@
+//
+//  FrameRecording.hpp
+//  LeapTracker
+//
+//  Raw tracking-frame recordings. The tracker can dump every frame it
+//  processes with --record-frames, and the LeapC stand-in replays the same
+//  files so sessions can be re-run without a device.
+//
+//  Layout (native endianness, same-platform replay only):
+//    FrameRecordingHeader
+//    repeated { FrameRecordingEntry, LEAP_HAND[nHands] }
+//
+#ifndef FrameRecording_hpp
+#define FrameRecording_hpp
+
+#include "LeapC.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#define FRAME_RECORDING_MAGIC 0x5246544C  // "LTFR"
+#define FRAME_RECORDING_VERSION 1
+
+struct FrameRecordingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t handSize;  // sizeof(LEAP_HAND) on the recording machine
+    uint32_t reserved;
+};
+
+struct FrameRecordingEntry {
+    int64_t frameId;
+    int64_t timestamp;  // LeapGetNow() microseconds at capture
+    int64_t trackingFrameId;
+    float framerate;
+    uint32_t nHands;
+};
+
+class FrameRecorder {
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    bool open(const std::string& path);
+    void write(const LEAP_TRACKING_EVENT* frame);
+    void close();
+
+    bool isOpen() const { return file.is_open(); }
+    uint64_t framesWritten() const { return frames; }
+
+private:
+    std::ofstream file;
+    uint64_t frames;
+};
+
+#endif /* FrameRecording_hpp */
@@ -0,0 +1,72 @@
+//
+//  FrameResampler.cpp
+//  LeapTracker
+//
+#include "FrameResampler.hpp"
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+FrameResampler::FrameResampler(double outputRate, int64_t delayMicros)
+    : outputRate(outputRate), delayMicros(delayMicros), produced(0), missed(0), skipped(0)
+{
+    if (outputRate <= 0) {
+        throw std::invalid_argument("Output rate must be greater than zero");
+    }
+    // Room for a two-hand frame up front so the first samples do not allocate
+    buffer.resize(sizeof(LEAP_TRACKING_EVENT) + FRAME_SNAPSHOT_MAX_HANDS * sizeof(LEAP_HAND));
+}
+
+const LEAP_TRACKING_EVENT* FrameResampler::sample(LEAP_CONNECTION connection, LEAP_DEVICE device, int64_t timestamp) {
+    uint64_t frameSize = 0;
+    eLeapRS result = device ? LeapGetFrameSizeEx(connection, device, timestamp, &frameSize)
+                            : LeapGetFrameSize(connection, timestamp, &frameSize);
+    if (result != eLeapRS_Success) {
+        return nullptr;
+    }
+    if (frameSize > buffer.size()) {
+        buffer.resize(frameSize);
+    }
+
+    LEAP_TRACKING_EVENT* frame = reinterpret_cast<LEAP_TRACKING_EVENT*>(buffer.data());
+    result = device ? LeapInterpolateFrameEx(connection, device, timestamp, frame, frameSize)
+                    : LeapInterpolateFrame(connection, timestamp, frame, frameSize);
+    if (result != eLeapRS_Success) {
+        return nullptr;
+    }
+    return frame;
+}
+
+void FrameResampler::run(LEAP_CONNECTION connection, LEAP_DEVICE device, const std::atomic<bool>& running, FrameRing& ring) {
+    using Clock = std::chrono::steady_clock;
+    const int64_t periodMicros = static_cast<int64_t>(1e6 / outputRate);
+    const Clock::duration period = std::chrono::microseconds(periodMicros);
+
+    // Tick k is due at start + k periods and samples LeapC time leapStart + k periods,
+    // so output spacing does not depend on how promptly this thread wakes.
+    Clock::time_point start = Clock::now();
+    int64_t leapStart = LeapGetNow() - delayMicros;
+    uint64_t tick = 0;
+
+    while (running) {
+        std::this_thread::sleep_until(start + tick * period);
+
+        // If we fell more than a period behind, skip the missed ticks rather than bursting
+        uint64_t dueTick = static_cast<uint64_t>((Clock::now() - start) / period);
+        if (dueTick > tick + 1) {
+            skipped.fetch_add(dueTick - tick - 1, std::memory_order_relaxed);
+            tick = dueTick;
+        }
+
+        const LEAP_TRACKING_EVENT* frame = sample(connection, device, leapStart + static_cast<int64_t>(tick) * periodMicros);
+        if (frame) {
+            ring.push(frame, LeapGetNow());
+            produced.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            missed.fetch_add(1, std::memory_order_relaxed);
+        }
+        tick++;
+    }
+}
+
+// end of FrameResampler.cpp //
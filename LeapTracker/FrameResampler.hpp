@@ -0,0 +1,50 @@
+//
+//  FrameResampler.hpp
+//  LeapTracker
+//
+//  Fixed-rate output clock. Instead of forwarding frames at whatever rate the
+//  device delivers, asks LeapC for the hand state at evenly spaced timestamps
+//  (LeapGetFrameSize + LeapInterpolateFrame) and feeds those into the frame
+//  ring. Targets trail LeapGetNow() by a fixed delay so each one falls between
+//  two frames the service already has.
+//
+#ifndef FrameResampler_hpp
+#define FrameResampler_hpp
+
+#include "LeapC.h"
+#include "FrameRing.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class FrameResampler {
+public:
+    FrameResampler(double outputRate, int64_t delayMicros);
+
+    double rate() const { return outputRate; }
+    int64_t delay() const { return delayMicros; }
+
+    // Interpolates the given device's frame at a LeapC timestamp into the reused buffer
+    // (the primary device if device is null). Returns nullptr if LeapC cannot produce
+    // it; the result is valid until the next call.
+    const LEAP_TRACKING_EVENT* sample(LEAP_CONNECTION connection, LEAP_DEVICE device, int64_t timestamp);
+
+    // Output clock: samples once per period into the ring until running is cleared.
+    // The connection and device must stay open until this returns.
+    void run(LEAP_CONNECTION connection, LEAP_DEVICE device, const std::atomic<bool>& running, FrameRing& ring);
+
+    uint64_t samplesProduced() const { return produced.load(std::memory_order_relaxed); }
+    uint64_t samplesMissed() const { return missed.load(std::memory_order_relaxed); }
+    uint64_t ticksSkipped() const { return skipped.load(std::memory_order_relaxed); }
+
+private:
+    double outputRate;
+    int64_t delayMicros;
+    std::vector<uint8_t> buffer;  // grown to the largest frame seen, never shrunk
+
+    std::atomic<uint64_t> produced;
+    std::atomic<uint64_t> missed;
+    std::atomic<uint64_t> skipped;
+};
+
+#endif /* FrameResampler_hpp */
@@ -0,0 +1,152 @@
+//
+//  FrameRing.cpp
+//  LeapTracker
+//
+#include "FrameRing.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+void FrameSnapshot::copyFrom(const LEAP_TRACKING_EVENT* frame) {
+    info = frame->info;
+    trackingFrameId = frame->tracking_frame_id;
+    framerate = frame->framerate;
+    nHands = std::min<uint32_t>(frame->nHands, FRAME_SNAPSHOT_MAX_HANDS);
+    std::memcpy(hands, frame->pHands, nHands * sizeof(LEAP_HAND));
+}
+
+LEAP_TRACKING_EVENT FrameSnapshot::view() const {
+    LEAP_TRACKING_EVENT event;
+    event.info = info;
+    event.tracking_frame_id = trackingFrameId;
+    event.nHands = nHands;
+    event.pHands = const_cast<LEAP_HAND*>(hands);
+    event.framerate = framerate;
+    return event;
+}
+
+FrameRing::FrameRing(size_t capacity, OverflowPolicy policy)
+    : overflowPolicy(policy), head(0), tail(0), overflows(0), closed(false), consumerWaiting(false)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("Frame ring capacity must be greater than zero");
+    }
+
+    // Round up to a power of two so positions map to slots with a mask
+    slotCount = 1;
+    while (slotCount < capacity) {
+        slotCount <<= 1;
+    }
+    mask = slotCount - 1;
+    slots = std::make_unique<Slot[]>(slotCount);
+    for (size_t i = 0; i < slotCount; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool FrameRing::push(const LEAP_TRACKING_EVENT* frame, int64_t polledAt) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    Slot& slot = slots[h & mask];
+
+    // Until it is copied out or dropped the slot still holds position h - slotCount
+    while (slot.sequence.load(std::memory_order_acquire) != h) {
+        if (overflowPolicy == OverflowPolicy::Block) {
+            if (closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        // Drop the oldest frame by claiming its position from the consumer
+        uint64_t t = h - slotCount;
+        if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        // The consumer claimed it first and is copying it out
+        std::this_thread::yield();
+    }
+
+    slot.frame.copyFrom(frame);
+    slot.frame.polledAt = polledAt;
+    slot.sequence.store(h + 1, std::memory_order_release);
+    // Sequentially consistent with consumerWaiting, so a consumer going to sleep either sees
+    // this frame or is seen here and woken
+    head.store(h + 1);
+    if (consumerWaiting.load()) {
+        wakeConsumer();
+    }
+    return true;
+}
+
+bool FrameRing::pop(FrameSnapshot& out) {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = slots[t & mask];
+        int64_t ready = static_cast<int64_t>(slot.sequence.load(std::memory_order_acquire) - (t + 1));
+        if (ready < 0) {
+            return false;
+        }
+        if (ready > 0) {
+            // The producer dropped position t and has already reused its slot
+            t = tail.load(std::memory_order_relaxed);
+            continue;
+        }
+        // Only the side that claims the position touches the frame; a failed CAS reloads t
+        if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel)) {
+            out = slot.frame;
+            slot.sequence.store(t + slotCount, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+bool FrameRing::waitPop(FrameSnapshot& out) {
+    while (!pop(out)) {
+        if (closed.load(std::memory_order_acquire)) {
+            // Frames pushed before close() are visible now
+            return pop(out);
+        }
+        std::unique_lock<std::mutex> lock(waitMutex);
+        consumerWaiting.store(true);
+        frameReady.wait(lock, [this] { return size() > 0 || closed.load(std::memory_order_acquire); });
+        consumerWaiting.store(false, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void FrameRing::close() {
+    closed.store(true, std::memory_order_release);
+    wakeConsumer();
+}
+
+void FrameRing::wakeConsumer() {
+    std::lock_guard<std::mutex> lock(waitMutex);
+    frameReady.notify_one();
+}
+
+size_t FrameRing::size() const {
+    uint64_t t = tail.load(std::memory_order_acquire);
+    // Sequentially consistent for waitPop. A frame can be popped before its head store is seen
+    uint64_t h = head.load();
+    return h > t ? static_cast<size_t>(h - t) : 0;
+}
+
+FrameRing::OverflowPolicy FrameRing::parsePolicy(const std::string& name) {
+    if (name == "drop-oldest") {
+        return OverflowPolicy::DropOldest;
+    }
+    if (name == "block") {
+        return OverflowPolicy::Block;
+    }
+    throw std::invalid_argument("Unknown frame ring policy: " + name);
+}
+
+const char* FrameRing::policyName(OverflowPolicy policy) {
+    return policy == OverflowPolicy::Block ? "block" : "drop-oldest";
+}
+
+// end of FrameRing.cpp //
@@ -0,0 +1,102 @@
+//
+//  FrameRing.hpp
+//  LeapTracker
+//
+//  Bounded single-producer/single-consumer ring of preallocated frame
+//  snapshots. The polling thread copies each LEAP_TRACKING_EVENT in and the
+//  processing thread copies it back out, so LeapPollConnection is never held
+//  up by CSV, OSC or WebSocket output.
+//
+//  Each slot carries a sequence number (as in Vyukov's bounded queue): a
+//  slot is written only once its previous frame has been copied out or
+//  dropped, and is read only once the producer has finished writing it.
+//  Under DropOldest the producer claims the oldest position from the
+//  consumer with a CAS on tail before overwriting it; if the consumer
+//  claimed it first the producer waits out that one copy.
+//
+#ifndef FrameRing_hpp
+#define FrameRing_hpp
+
+#include "LeapC.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// LeapC reports at most one left and one right hand per frame
+#define FRAME_SNAPSHOT_MAX_HANDS 2
+
+// Self-contained copy of a tracking event; hands are stored inline so the
+// snapshot can be copied without chasing LeapC-owned memory.
+struct FrameSnapshot {
+    LEAP_FRAME_HEADER info;
+    int64_t trackingFrameId;
+    float framerate;
+    uint32_t nHands;
+    int64_t polledAt;  // LeapGetNow() when the polling thread received the frame
+    LEAP_HAND hands[FRAME_SNAPSHOT_MAX_HANDS];
+
+    void copyFrom(const LEAP_TRACKING_EVENT* frame);
+    // Rebuilds a LEAP_TRACKING_EVENT whose pHands points into this snapshot
+    LEAP_TRACKING_EVENT view() const;
+};
+
+class FrameRing {
+public:
+    enum class OverflowPolicy {
+        DropOldest,  // overwrite the oldest queued frame and count an overflow
+        Block        // make the producer wait until the consumer frees a slot
+    };
+
+    FrameRing(size_t capacity, OverflowPolicy policy);
+
+    // Producer side; returns false only if the ring was closed while blocked
+    bool push(const LEAP_TRACKING_EVENT* frame, int64_t polledAt);
+    // Consumer side; returns false if the ring is empty
+    bool pop(FrameSnapshot& out);
+    // Consumer side; sleeps until a frame arrives, returns false once the ring is closed and empty
+    bool waitPop(FrameSnapshot& out);
+
+    // Releases a producer blocked under OverflowPolicy::Block and a consumer in waitPop
+    void close();
+
+    size_t size() const;
+    size_t capacity() const { return slotCount; }
+    OverflowPolicy policy() const { return overflowPolicy; }
+    uint64_t overflowCount() const { return overflows.load(std::memory_order_relaxed); }
+    uint64_t pushedCount() const { return head.load(std::memory_order_relaxed); }
+
+    static OverflowPolicy parsePolicy(const std::string& name);
+    static const char* policyName(OverflowPolicy policy);
+
+private:
+    // sequence == position: free for the producer to write position
+    // sequence == position + 1: holds position, ready to be claimed from tail
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        FrameSnapshot frame;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t slotCount;
+    size_t mask;
+    OverflowPolicy overflowPolicy;
+
+    // Monotonic positions; slot index is position & mask
+    alignas(64) std::atomic<uint64_t> head;  // next position the producer writes
+    alignas(64) std::atomic<uint64_t> tail;  // next position to claim, by the consumer or a dropping producer
+    alignas(64) std::atomic<uint64_t> overflows;
+    std::atomic<bool> closed;
+
+    // Lets an idle consumer sleep; the producer only takes the mutex while one is waiting
+    std::mutex waitMutex;
+    std::condition_variable frameReady;
+    std::atomic<bool> consumerWaiting;
+
+    void wakeConsumer();
+};
+
+#endif /* FrameRing_hpp */
@@ -0,0 +1,109 @@
+//
+//  HandChannels.hpp
+//  LeapTracker
+//
+//  Every per-hand value the tracker outputs, in one flat float array so
+//  stages such as the channel filter can run over all of them at once.
+//  processFrame fills it after the compute stage and the CSV, JSON and OSC
+//  output read from it.
+//
+#ifndef HandChannels_hpp
+#define HandChannels_hpp
+
+#include "ChannelFilter.hpp"
+#include "ExerciseMetrics.hpp"
+#include <string>
+
+struct HandChannels {
+    // Offsets of each group in values
+    enum Offset {
+        Tips = 0,                                   // thumb..pinky tip x, y, z
+        Joints = Tips + 15,                         // thumb..pinky MCP, PIP, DIP
+        Wrist = Joints + 15,                        // x, y, z
+        WristAngles = Wrist + 3,                    // flexion, extension, radial deviation, ulnar deviation
+        Palm = WristAngles + 4,                     // x, y, z
+        PalmAngles = Palm + 3,                      // roll, pitch, yaw
+        ThumbDistances = PalmAngles + 3,            // thumb tip to index, middle, ring, pinky tips
+        Metrics = ThumbDistances + 4,               // the exercise pipeline's metrics, in pipeline order
+        Abduction = Metrics + static_cast<int>(kMetricCount),   // MCP abduction per finger
+        Count = Abduction + 5
+    };
+
+    // Rounded up to whole 8-float vectors for the filter
+    static const int kCapacity = (Count + 7) / 8 * 8;
+
+    alignas(32) float values[kCapacity];
+
+    float& operator[](int index) { return values[index]; }
+    float operator[](int index) const { return values[index]; }
+
+    // Filter settings for each channel group, in that group's units: mm,
+    // degrees, or 0..1 for metrics
+    static ChannelFilter::Parameters defaultParameters(int channel);
+
+    // CSV column of a channel outside the metrics group, e.g. "Index PIP"
+    static std::string columnName(int channel);
+};
+
+inline std::string HandChannels::columnName(int channel) {
+    static const char* fingers[5] = {"Thumb", "Index", "Middle", "Ring", "Pinky"};
+    static const char* axes[3] = {"X", "Y", "Z"};
+    static const char* joints[3] = {"MCP", "PIP", "DIP"};
+    static const char* wristAngles[4] = {"Wrist Flexion", "Wrist Extension", "Radial Deviation", "Ulnar Deviation"};
+    static const char* palmAngles[3] = {"Palm Roll", "Palm Pitch", "Palm Yaw"};
+    if (channel < Joints) {
+        return std::string(fingers[(channel - Tips) / 3]) + " " + axes[(channel - Tips) % 3];
+    }
+    if (channel < Wrist) {
+        return std::string(fingers[(channel - Joints) / 3]) + " " + joints[(channel - Joints) % 3];
+    }
+    if (channel < WristAngles) {
+        return std::string("Wrist ") + axes[channel - Wrist];
+    }
+    if (channel < Palm) {
+        return wristAngles[channel - WristAngles];
+    }
+    if (channel < PalmAngles) {
+        return std::string("Palm ") + axes[channel - Palm];
+    }
+    if (channel < ThumbDistances) {
+        return palmAngles[channel - PalmAngles];
+    }
+    if (channel < Metrics) {
+        return std::string("Thumb-") + fingers[channel - ThumbDistances + 1] + " Distance";
+    }
+    if (channel >= Abduction && channel < Count) {
+        return std::string(fingers[channel - Abduction]) + " Abduction";
+    }
+    return "Channel " + std::to_string(channel);
+}
+
+inline ChannelFilter::Parameters HandChannels::defaultParameters(int channel) {
+    ChannelFilter::Parameters parameters;
+    if (channel >= Metrics && channel < Abduction) {
+        parameters.minCutoff = 1.0f;
+        parameters.beta = 2.0f;
+        parameters.processNoise = 10.0f;
+        parameters.measurementNoise = 1e-4f;
+    } else if ((channel >= Joints && channel < Wrist) || (channel >= WristAngles && channel < Palm) ||
+               (channel >= PalmAngles && channel < ThumbDistances) || channel >= Abduction) {
+        // Degrees
+        parameters.minCutoff = 1.0f;
+        parameters.beta = 0.01f;
+        parameters.processNoise = 1e6f;
+        parameters.measurementNoise = 1.0f;
+        // Roll and yaw come from atan2 and wrap at +-180; a hand pointing away from the user sits on the wrap
+        if (channel == PalmAngles || channel == PalmAngles + 2) {
+            parameters.period = 360.0f;
+        }
+    } else {
+        // Millimetres
+        parameters.minCutoff = 1.0f;
+        parameters.beta = 0.02f;
+        parameters.processNoise = 1e6f;
+        parameters.measurementNoise = 0.5f;
+    }
+    return parameters;
+}
+
+#endif /* HandChannels_hpp */
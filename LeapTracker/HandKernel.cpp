@@ -0,0 +1,299 @@
+//
+//  HandKernel.cpp
+//  LeapTracker
+//
+#include "HandKernel.hpp"
+#include "FastMath.hpp"
+#include "SimdOps.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const float kRadToDeg = static_cast<float>(180.0 / M_PI);
+// Shorter bones (the Leap thumb metacarpal has zero length) have no direction
+const float kMinBoneLength = 1e-4f;
+
+// Kernel output, in the same bone-major lane order as the input
+struct BoneResults {
+    alignas(32) float dirX[HandBonesSoA::kLanes], dirY[HandBonesSoA::kLanes], dirZ[HandBonesSoA::kLanes];
+    alignas(32) float length[HandBonesSoA::kLanes];
+    alignas(32) float cosine[3 * HandBonesSoA::kFingerLanes];   // joint-major
+    alignas(32) float sine[3 * HandBonesSoA::kFingerLanes];     // |a x b| of the two bone directions
+    alignas(32) float angle[3 * HandBonesSoA::kFingerLanes];    // degrees, joint-major
+    alignas(32) float tipDistance[HandBonesSoA::kTipLanes];
+};
+
+// atan2 of each lane pair, in degrees, as the Trig policy computes it: with
+// fast math the polynomial runs across lanes, otherwise each lane calls
+// Trig::atan2 (libm in double precision)
+void atan2Degrees(const float* y, const float* x, float* out, int n) {
+#if LEAPTRACKER_FAST_MATH
+    const vfloat radToDeg = vset(kRadToDeg);
+    for (int i = 0; i < n; i += kWidth) {
+        vstore(out + i, vmul(vatan2(vload(y + i), vload(x + i)), radToDeg));
+    }
+#else
+    for (int i = 0; i < n; i++) {
+        out[i] = Trig::atan2(y[i], x[i]) * kRadToDeg;
+    }
+#endif
+}
+
+void runKernel(const HandBonesSoA& in, BoneResults& out) {
+    const vfloat minLength = vset(kMinBoneLength);
+    for (int i = 0; i < HandBonesSoA::kLanes; i += kWidth) {
+        vfloat dx = vsub(vload(in.nextX + i), vload(in.prevX + i));
+        vfloat dy = vsub(vload(in.nextY + i), vload(in.prevY + i));
+        vfloat dz = vsub(vload(in.nextZ + i), vload(in.prevZ + i));
+        vfloat length = vsqrt(vdot(dx, dy, dz, dx, dy, dz));
+        // Zero-length bones get a zero direction instead of NaN
+        vfloat scale = vmax(length, minLength);
+        vstore(out.dirX + i, vdiv(dx, scale));
+        vstore(out.dirY + i, vdiv(dy, scale));
+        vstore(out.dirZ + i, vdiv(dz, scale));
+        vstore(out.length + i, length);
+    }
+
+    // Joint j of every finger is between bone block j and bone block j + 1.
+    // Its angle is atan2(|a x b|, a . b): acos of a float cosine loses up to
+    // 0.03 degrees on nearly straight joints, where the cosine is close to 1.
+    const vfloat one = vset(1.0f), minusOne = vset(-1.0f);
+    for (int i = 0; i < 3 * HandBonesSoA::kFingerLanes; i += kWidth) {
+        const int next = i + HandBonesSoA::kFingerLanes;
+        vfloat ax = vload(out.dirX + i), ay = vload(out.dirY + i), az = vload(out.dirZ + i);
+        vfloat bx = vload(out.dirX + next), by = vload(out.dirY + next), bz = vload(out.dirZ + next);
+        vfloat c = vdot(ax, ay, az, bx, by, bz);
+        vfloat cx = vsub(vmul(ay, bz), vmul(az, by));
+        vfloat cy = vsub(vmul(az, bx), vmul(ax, bz));
+        vfloat cz = vsub(vmul(ax, by), vmul(ay, bx));
+        vstore(out.cosine + i, vmax(minusOne, vmin(one, c)));
+        vstore(out.sine + i, vsqrt(vdot(cx, cy, cz, cx, cy, cz)));
+    }
+
+    atan2Degrees(out.sine, out.cosine, out.angle, 3 * HandBonesSoA::kFingerLanes);
+
+    const vfloat thumbX = vset(in.thumbX), thumbY = vset(in.thumbY), thumbZ = vset(in.thumbZ);
+    for (int i = 0; i < HandBonesSoA::kTipLanes; i += kWidth) {
+        vfloat dx = vsub(thumbX, vload(in.tipX + i));
+        vfloat dy = vsub(thumbY, vload(in.tipY + i));
+        vfloat dz = vsub(thumbZ, vload(in.tipZ + i));
+        vstore(out.tipDistance + i, vsqrt(vdot(dx, dy, dz, dx, dy, dz)));
+    }
+}
+
+LEAP_VECTOR normalised(const LEAP_VECTOR& v) {
+    float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    if (length < kMinBoneLength) {
+        LEAP_VECTOR zero = { 0, 0, 0 };
+        return zero;
+    }
+    LEAP_VECTOR unit = { v.x / length, v.y / length, v.z / length };
+    return unit;
+}
+
+LEAP_VECTOR direction(const LEAP_VECTOR& from, const LEAP_VECTOR& to) {
+    LEAP_VECTOR d = { to.x - from.x, to.y - from.y, to.z - from.z };
+    return d;
+}
+
+// Fields that do not depend on the finger bones
+void computeHandFrame(const LEAP_HAND& hand, HandGeometry& out) {
+    out.armDirection = normalised(direction(hand.arm.prev_joint, hand.arm.next_joint));
+    out.palmDirection = normalised(hand.palm.direction);
+    out.palmNormal = normalised(hand.palm.normal);
+}
+
+// Flexion and lateral deviation of each child rotation relative to its parent,
+// both measured on the child's forward axis (-Z) in the parent's frame, in which
+// +Y is the back of the hand and +X the little-finger side of a right hand
+void runKinematicsKernel(const HandRotationsSoA& in, float* flexion, float* deviation) {
+    const vfloat one = vset(1.0f), two = vset(2.0f);
+    alignas(32) float palmars[HandRotationsSoA::kLanes], alongs[HandRotationsSoA::kLanes];
+    alignas(32) float laterals[HandRotationsSoA::kLanes], sagittals[HandRotationsSoA::kLanes];
+    for (int i = 0; i < HandRotationsSoA::kLanes; i += kWidth) {
+        vfloat px = vload(in.parentX + i), py = vload(in.parentY + i), pz = vload(in.parentZ + i), pw = vload(in.parentW + i);
+        vfloat cx = vload(in.childX + i), cy = vload(in.childY + i), cz = vload(in.childZ + i), cw = vload(in.childW + i);
+
+        // Relative rotation conj(parent) * child
+        vfloat w = vadd(vadd(vmul(pw, cw), vmul(px, cx)), vadd(vmul(py, cy), vmul(pz, cz)));
+        vfloat x = vsub(vadd(vmul(pw, cx), vmul(pz, cy)), vadd(vmul(px, cw), vmul(py, cz)));
+        vfloat y = vsub(vadd(vmul(pw, cy), vmul(px, cz)), vadd(vmul(py, cw), vmul(pz, cx)));
+        vfloat z = vsub(vadd(vmul(pw, cz), vmul(py, cx)), vadd(vmul(px, cy), vmul(pz, cw)));
+
+        // Child forward is -(third column of the rotation matrix)
+        vfloat palmar = vmul(two, vsub(vmul(y, z), vmul(w, x)));               // -forward.y
+        vfloat along = vsub(one, vmul(two, vadd(vmul(x, x), vmul(y, y))));     // -forward.z
+        vfloat lateral = vmul(vset(-2.0f), vadd(vmul(x, z), vmul(w, y)));      //  forward.x
+
+        vstore(palmars + i, palmar);
+        vstore(alongs + i, along);
+        vstore(laterals + i, lateral);
+        vstore(sagittals + i, vsqrt(vadd(vmul(palmar, palmar), vmul(along, along))));
+    }
+    atan2Degrees(palmars, alongs, flexion, HandRotationsSoA::kLanes);
+    atan2Degrees(laterals, sagittals, deviation, HandRotationsSoA::kLanes);
+}
+
+}  // namespace
+
+void HandRotationsSoA::load(const LEAP_HAND& hand) {
+    auto set = [this](int lane, const LEAP_QUATERNION& parent, const LEAP_QUATERNION& child) {
+        parentX[lane] = parent.x; parentY[lane] = parent.y; parentZ[lane] = parent.z; parentW[lane] = parent.w;
+        childX[lane] = child.x;   childY[lane] = child.y;   childZ[lane] = child.z;   childW[lane] = child.w;
+    };
+    for (int f = 0; f < 5; f++) {
+        const LEAP_DIGIT& digit = hand.digits[f];
+        for (int j = 0; j < 3; j++) {
+            set(f * 3 + j, digit.bones[j].rotation, digit.bones[j + 1].rotation);
+        }
+    }
+    set(kWristLane, hand.arm.rotation, hand.palm.orientation);
+}
+
+void computeHandKinematics(const LEAP_HAND& hand, HandKinematics& out) {
+    HandRotationsSoA rotations;
+    rotations.load(hand);
+    alignas(32) float flexion[HandRotationsSoA::kLanes];
+    alignas(32) float deviation[HandRotationsSoA::kLanes];
+    runKinematicsKernel(rotations, flexion, deviation);
+
+    // A left hand is a mirrored right hand, so its little-finger side is -X
+    float ulnarSign = hand.type == eLeapHandType_Left ? -1.0f : 1.0f;
+    for (int i = 0; i < 15; i++) {
+        out.flexion[i / 3][i % 3] = flexion[i];
+        out.abduction[i / 3][i % 3] = ulnarSign * deviation[i];
+    }
+    out.wristFlexion = flexion[HandRotationsSoA::kWristLane];
+    out.wristDeviation = ulnarSign * deviation[HandRotationsSoA::kWristLane];
+}
+
+JointAngleSource parseJointAngleSource(const std::string& name) {
+    if (name == "position") {
+        return JointAngleSource::Position;
+    }
+    if (name == "quaternion") {
+        return JointAngleSource::Quaternion;
+    }
+    throw std::invalid_argument("Unknown joint angle source: " + name);
+}
+
+void HandBonesSoA::load(const LEAP_HAND& hand) {
+    for (int b = 0; b < 4; b++) {
+        for (int f = 0; f < kFingerLanes; f++) {
+            int lane = b * kFingerLanes + f;
+            if (f < 5) {
+                const LEAP_BONE& bone = hand.digits[f].bones[b];
+                prevX[lane] = bone.prev_joint.x; prevY[lane] = bone.prev_joint.y; prevZ[lane] = bone.prev_joint.z;
+                nextX[lane] = bone.next_joint.x; nextY[lane] = bone.next_joint.y; nextZ[lane] = bone.next_joint.z;
+            } else {
+                // Padding lanes: unit bones along x, so they stay finite
+                prevX[lane] = 0; prevY[lane] = 0; prevZ[lane] = 0;
+                nextX[lane] = 1; nextY[lane] = 0; nextZ[lane] = 0;
+            }
+        }
+    }
+
+    thumbX = hand.thumb.distal.next_joint.x;
+    thumbY = hand.thumb.distal.next_joint.y;
+    thumbZ = hand.thumb.distal.next_joint.z;
+    for (int i = 0; i < kTipLanes; i++) {
+        const LEAP_VECTOR& tip = i < 4 ? hand.digits[i + 1].distal.next_joint : hand.thumb.distal.next_joint;
+        tipX[i] = tip.x;
+        tipY[i] = tip.y;
+        tipZ[i] = tip.z;
+    }
+}
+
+void computeHandGeometry(const LEAP_HAND& hand, HandGeometry& out) {
+    HandBonesSoA bones;
+    bones.load(hand);
+    BoneResults results;
+    runKernel(bones, results);
+
+    for (int f = 0; f < 5; f++) {
+        for (int b = 0; b < 4; b++) {
+            int lane = b * HandBonesSoA::kFingerLanes + f;
+            LEAP_VECTOR& dir = out.boneDirections[f][b];
+            dir.x = results.dirX[lane];
+            dir.y = results.dirY[lane];
+            dir.z = results.dirZ[lane];
+            out.boneLengths[f][b] = results.length[lane];
+        }
+    }
+
+    out.totalFlexion = 0.0f;
+    for (int f = 0; f < 5; f++) {
+        for (int j = 0; j < 3; j++) {
+            // A joint next to a zero-length bone is treated as straight
+            bool degenerate = out.boneLengths[f][j] < kMinBoneLength || out.boneLengths[f][j + 1] < kMinBoneLength;
+            int lane = j * HandBonesSoA::kFingerLanes + f;
+            out.jointCosines[f][j] = degenerate ? 1.0f : results.cosine[lane];
+            out.jointAngles[f][j] = degenerate ? 0.0f : results.angle[lane];
+            out.totalFlexion += out.jointAngles[f][j];
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        out.thumbDistances[i] = results.tipDistance[i];
+    }
+    computeHandFrame(hand, out);
+}
+
+void computeHandGeometryScalar(const LEAP_HAND& hand, HandGeometry& out) {
+    out.totalFlexion = 0.0f;
+    for (int f = 0; f < 5; f++) {
+        const LEAP_DIGIT& finger = hand.digits[f];
+        for (int b = 0; b < 4; b++) {
+            LEAP_VECTOR d = direction(finger.bones[b].prev_joint, finger.bones[b].next_joint);
+            out.boneLengths[f][b] = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+            out.boneDirections[f][b] = normalised(d);
+        }
+        out.jointAngles[f][0] = calculateAngle(finger.metacarpal.prev_joint, finger.metacarpal.next_joint, finger.proximal.next_joint);
+        out.jointAngles[f][1] = calculateAngle(finger.metacarpal.next_joint, finger.proximal.next_joint, finger.intermediate.next_joint);
+        out.jointAngles[f][2] = calculateAngle(finger.proximal.next_joint, finger.intermediate.next_joint, finger.distal.next_joint);
+        for (int j = 0; j < 3; j++) {
+            out.jointCosines[f][j] = std::cos(out.jointAngles[f][j] / kRadToDeg);
+            out.totalFlexion += out.jointAngles[f][j];
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        out.thumbDistances[i] = calculateDistance(hand.thumb.distal.next_joint, hand.digits[i + 1].distal.next_joint);
+    }
+    computeHandFrame(hand, out);
+}
+
+const char* handKernelIsa() {
+#if LEAPTRACKER_SIMD_AVX2
+    return "avx2";
+#elif LEAPTRACKER_SIMD_SSE2
+    return "sse2";
+#elif LEAPTRACKER_SIMD_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+float calculateDistance(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2) {
+    float dx = p1.x - p2.x;
+    float dy = p1.y - p2.y;
+    float dz = p1.z - p2.z;
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+float calculateAngle(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2, const LEAP_VECTOR& p3) {
+    LEAP_VECTOR v1 = { p2.x - p1.x, p2.y - p1.y, p2.z - p1.z };
+    LEAP_VECTOR v2 = { p3.x - p2.x, p3.y - p2.y, p3.z - p2.z };
+    float dot = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+    float mag1 = std::sqrt(v1.x * v1.x + v1.y * v1.y + v1.z * v1.z);
+    float mag2 = std::sqrt(v2.x * v2.x + v2.y * v2.y + v2.z * v2.z);
+    return Trig::acos(dot / (mag1 * mag2)) * 180.0 / M_PI;
+}
+
+// end of HandKernel.cpp //
@@ -0,0 +1,103 @@
+//
+//  HandKernel.hpp
+//  LeapTracker
+//
+//  Derived geometry for one hand, computed once per frame and shared by the
+//  CSV/JSON/OSC output and every exercise metric. The 20 finger bones are
+//  gathered into structure-of-arrays form and normalised in one vectorised
+//  pass (AVX2 or SSE2 on x86-64, NEON on arm64, plain loops elsewhere), after
+//  which the 15 joint cosines are dot products of neighbouring unit bones
+//  and the angles are atan2 of the cross and dot products, through the Trig
+//  policy of FastMath.hpp. The scalar reference keeps the original one-call-per-angle formulation
+//  for comparison and benchmarking. HandKinematics is the alternative
+//  quaternion path, batched the same way over the bones' relative rotations.
+//
+#ifndef HandKernel_hpp
+#define HandKernel_hpp
+
+#include "LeapC.h"
+#include <string>
+
+// Finger order matches LEAP_HAND::digits: thumb, index, middle, ring, pinky.
+// Bone order matches LEAP_DIGIT::bones: metacarpal, proximal, intermediate, distal.
+struct HandGeometry {
+    LEAP_VECTOR boneDirections[5][4];   // unit vectors from prev_joint to next_joint
+    float boneLengths[5][4];            // mm
+    float jointCosines[5][3];           // MCP, PIP, DIP: cosine between neighbouring bones
+    float jointAngles[5][3];            // MCP, PIP, DIP in degrees
+    float totalFlexion;                 // sum of the 15 joint angles in degrees
+    float thumbDistances[4];            // thumb tip to index, middle, ring and pinky tips in mm
+    LEAP_VECTOR armDirection;           // unit vector from elbow to wrist
+    LEAP_VECTOR palmDirection;          // unit palm direction
+    LEAP_VECTOR palmNormal;             // unit palm normal
+};
+
+// Bone endpoints gathered for the kernel. Lanes are bone-major: lane
+// bone * kFingerLanes + finger, so one joint's cosines across all five fingers
+// are a single dot product of two contiguous blocks.
+struct HandBonesSoA {
+    static const int kFingerLanes = 8;                 // 5 fingers padded to a whole vector
+    static const int kLanes = 4 * kFingerLanes;
+    static const int kTipLanes = 8;                     // 4 fingertips padded likewise
+
+    alignas(32) float prevX[kLanes], prevY[kLanes], prevZ[kLanes];
+    alignas(32) float nextX[kLanes], nextY[kLanes], nextZ[kLanes];
+    alignas(32) float tipX[kTipLanes], tipY[kTipLanes], tipZ[kTipLanes];   // index, middle, ring, pinky
+    float thumbX, thumbY, thumbZ;
+
+    void load(const LEAP_HAND& hand);
+};
+
+// Joint angles from LEAP_BONE.rotation, LEAP_PALM.orientation and
+// LEAP_ARM.rotation instead of joint positions. Each angle comes from the
+// rotation of a bone relative to its parent, which also separates flexion
+// from abduction/adduction.
+struct HandKinematics {
+    float flexion[5][3];       // MCP, PIP, DIP in degrees, positive towards the palm
+    float abduction[5][3];     // MCP, PIP, DIP in degrees, positive towards the little-finger side
+    float wristFlexion;        // palm relative to forearm in degrees: positive flexion, negative extension
+    float wristDeviation;      // degrees: positive ulnar, negative radial
+};
+
+// Parent and child rotations for the kinematics kernel; lane i < 15 is
+// finger i / 3, joint i % 3, and the last lane is the wrist (arm to palm)
+struct HandRotationsSoA {
+    static const int kLanes = 16;
+    static const int kWristLane = 15;
+
+    alignas(32) float parentX[kLanes], parentY[kLanes], parentZ[kLanes], parentW[kLanes];
+    alignas(32) float childX[kLanes], childY[kLanes], childZ[kLanes], childW[kLanes];
+
+    void load(const LEAP_HAND& hand);
+};
+
+// Index of a hand type in per-hand arrays: 0 left, 1 right
+const int kHandSlots = 2;
+inline int handSlot(eLeapHandType type) { return type == eLeapHandType_Left ? 0 : 1; }
+inline const char* handSlotName(int slot) { return slot == 0 ? "left" : "right"; }
+inline const char* handTypeName(eLeapHandType type) { return handSlotName(handSlot(type)); }
+
+// Which joint angles the tracker writes to its outputs
+enum class JointAngleSource {
+    Position,      // angle between neighbouring bones, from joint positions
+    Quaternion     // signed flexion and abduction from bone rotations
+};
+
+JointAngleSource parseJointAngleSource(const std::string& name);
+
+// Vectorised path used by the tracker
+void computeHandGeometry(const LEAP_HAND& hand, HandGeometry& out);
+// One calculation per output from the LEAP_HAND, as the tracker used to do
+void computeHandGeometryScalar(const LEAP_HAND& hand, HandGeometry& out);
+// Vectorised quaternion path; atan2 goes through the Trig policy (libm in double, or the
+// FastMath polynomial under LEAPTRACKER_FAST_MATH)
+void computeHandKinematics(const LEAP_HAND& hand, HandKinematics& out);
+
+// Instruction set the vectorised path was built for: "avx2", "sse2", "neon" or "scalar"
+const char* handKernelIsa();
+
+float calculateDistance(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2);
+// Angle in degrees between the segments p1->p2 and p2->p3
+float calculateAngle(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2, const LEAP_VECTOR& p3);
+
+#endif /* HandKernel_hpp */
@@ -0,0 +1,28 @@
+//
+//  HandStateTable.cpp
+//  LeapTracker
+//
+#include "HandStateTable.hpp"
+#include "HandChannels.hpp"
+
+HandStateTable::HandStateTable(ChannelFilter::Type filterType) {
+    for (Entry& entry : entries) {
+        entry.filter = std::make_unique<ChannelFilter>(filterType, HandChannels::Count);
+        for (int c = 0; c < HandChannels::Count; c++) {
+            entry.filter->setParameters(c, HandChannels::defaultParameters(c));
+        }
+    }
+}
+
+HandStateTable::Entry& HandStateTable::lookup(const LEAP_HAND& hand) {
+    Entry& entry = entries[handSlot(hand.type)];
+    if (!entry.seen || entry.handId != hand.id) {
+        entry.handId = hand.id;
+        entry.seen = true;
+        entry.filter->reset();
+    }
+    entry.framesSeen++;
+    return entry;
+}
+
+// end of HandStateTable.cpp //
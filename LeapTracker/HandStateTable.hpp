@@ -0,0 +1,42 @@
+//
+//  HandStateTable.hpp
+//  LeapTracker
+//
+//  Per-hand state that has to follow one hand from frame to frame, in a
+//  flat table with one entry per hand type. Each entry remembers the
+//  LEAP_HAND.id it last saw: when LeapC starts tracking a new hand of that
+//  type (a new id), the entry's filter restarts rather than smoothing from
+//  the previous hand's positions. Statistics, events and calibration are
+//  per patient hand rather than per tracking id, so they stay indexed by
+//  handSlot() and survive a hand leaving and re-entering the view.
+//
+#ifndef HandStateTable_hpp
+#define HandStateTable_hpp
+
+#include "LeapC.h"
+#include "ChannelFilter.hpp"
+#include "HandKernel.hpp"
+#include <cstdint>
+#include <memory>
+
+class HandStateTable {
+public:
+    struct Entry {
+        uint32_t handId = 0;
+        bool seen = false;
+        uint64_t framesSeen = 0;
+        std::unique_ptr<ChannelFilter> filter;
+    };
+
+    // Filters are set up with HandChannels' default parameters
+    explicit HandStateTable(ChannelFilter::Type filterType);
+
+    // The entry for this hand's type, restarted if the hand's id is new
+    Entry& lookup(const LEAP_HAND& hand);
+    const Entry& entry(int slot) const { return entries[slot]; }
+
+private:
+    Entry entries[kHandSlots];
+};
+
+#endif /* HandStateTable_hpp */
@@ -0,0 +1,43 @@
+//
+//  LatencyHistogram.hpp
+//  LeapTracker
+//
+//  Fixed-size log-linear histogram: values are bucketed by power of two with
+//  16 linear sub-buckets each, giving ~6% relative precision from 1 ns to
+//  about 18 minutes with no allocation. One thread records, any thread may
+//  read percentiles.
+//
+#ifndef LatencyHistogram_hpp
+#define LatencyHistogram_hpp
+
+#include <atomic>
+#include <cstdint>
+
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Upper bound of the bucket containing the given quantile (0..1), in nanoseconds
+    uint64_t percentile(double quantile) const;
+
+private:
+    static const int kSubBucketBits = 4;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static const int kMagnitudes = 40 - kSubBucketBits + 1;
+    static const int kBuckets = (kMagnitudes + 1) * kSubBuckets;
+
+    std::atomic<uint64_t> buckets[kBuckets];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> maximum;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+};
+
+#endif /* LatencyHistogram_hpp */
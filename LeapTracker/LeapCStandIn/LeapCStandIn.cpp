@@ -0,0 +1,711 @@
+//
+//  LeapCStandIn.cpp
+//  LeapTracker
+//
+//  Hardware-free implementation of the LeapC entry points LeapTracker uses.
+//  Tracking events come either from a recording made with --record-frames or
+//  from SyntheticHand, and are paced at real time, a fixed multiple of real
+//  time, or as fast as the caller can poll.
+//
+//  Configured through the environment, since the LeapC API has no room for it:
+//    LEAPC_STANDIN_SOURCE  "synthetic" (default) or a path to a frame recording
+//    LEAPC_STANDIN_SPEED   "realtime" (default), "max", or a playback multiplier
+//    LEAPC_STANDIN_FPS     synthetic frame rate (default 120)
+//    LEAPC_STANDIN_HANDS   synthetic hands, 1 or 2 (default 1)
+//    LEAPC_STANDIN_FRAMES  stop after this many frames, 0 for no limit (default 0)
+//    LEAPC_STANDIN_LOOP    "1" to loop a recording instead of stopping at its end
+//    LEAPC_STANDIN_DEVICES number of controllers to report, 1-8 (default 1)
+//
+//  Each controller has its own source, pacing and serial number. Clients that
+//  are not multi-device aware only receive tracking from the first one;
+//  multi-device aware clients receive it from every device they subscribe to.
+//
+//  Delivered frames are kept in a short history so LeapInterpolateFrame can
+//  blend the two frames either side of a requested timestamp.
+//
+#include "LeapC.h"
+#include "FrameRecording.hpp"
+#include "SyntheticHand.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t kMaxHands = 2;
+const uint32_t kMaxDevices = 8;
+// About half a second at 120 fps; interpolation targets further back fail as too early
+const size_t kHistoryFrames = 64;
+
+struct StandInConfig {
+    std::string source = "synthetic";
+    double speed = 1.0;  // 0 plays flat-out
+    double fps = 120.0;
+    uint32_t hands = 1;
+    uint64_t frameLimit = 0;
+    bool loop = false;
+    uint32_t devices = 1;
+
+    static StandInConfig fromEnvironment() {
+        StandInConfig config;
+        if (const char* value = std::getenv("LEAPC_STANDIN_SOURCE")) {
+            config.source = value;
+        }
+        if (const char* value = std::getenv("LEAPC_STANDIN_SPEED")) {
+            std::string speed = value;
+            if (speed == "max") {
+                config.speed = 0.0;
+            } else if (speed != "realtime") {
+                config.speed = std::max(0.0, std::atof(value));
+            }
+        }
+        if (const char* value = std::getenv("LEAPC_STANDIN_FPS")) {
+            config.fps = std::max(1.0, std::atof(value));
+        }
+        if (const char* value = std::getenv("LEAPC_STANDIN_HANDS")) {
+            config.hands = std::min<uint32_t>(kMaxHands, std::max(1, std::atoi(value)));
+        }
+        if (const char* value = std::getenv("LEAPC_STANDIN_FRAMES")) {
+            config.frameLimit = std::strtoull(value, nullptr, 10);
+        }
+        if (const char* value = std::getenv("LEAPC_STANDIN_LOOP")) {
+            config.loop = std::string(value) == "1";
+        }
+        if (const char* value = std::getenv("LEAPC_STANDIN_DEVICES")) {
+            config.devices = std::min<uint32_t>(kMaxDevices, std::max(1, std::atoi(value)));
+        }
+        return config;
+    }
+};
+
+int64_t steadyMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct HistoryFrame {
+    LEAP_TRACKING_EVENT event;
+    LEAP_HAND hands[kMaxHands];
+};
+
+LEAP_VECTOR lerp(const LEAP_VECTOR& a, const LEAP_VECTOR& b, float t) {
+    LEAP_VECTOR out;
+    for (int i = 0; i < 3; i++) {
+        out.v[i] = a.v[i] + (b.v[i] - a.v[i]) * t;
+    }
+    return out;
+}
+
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// Normalised lerp along the shorter arc; close enough to slerp between adjacent frames
+LEAP_QUATERNION nlerp(const LEAP_QUATERNION& a, const LEAP_QUATERNION& b, float t) {
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    float sign = dot < 0 ? -1.0f : 1.0f;
+    LEAP_QUATERNION out;
+    float length = 0;
+    for (int i = 0; i < 4; i++) {
+        out.v[i] = a.v[i] + (sign * b.v[i] - a.v[i]) * t;
+        length += out.v[i] * out.v[i];
+    }
+    length = std::sqrt(length);
+    for (int i = 0; i < 4; i++) {
+        out.v[i] = length > 0 ? out.v[i] / length : a.v[i];
+    }
+    return out;
+}
+
+LEAP_BONE lerp(const LEAP_BONE& a, const LEAP_BONE& b, float t) {
+    LEAP_BONE out = a;
+    out.prev_joint = lerp(a.prev_joint, b.prev_joint, t);
+    out.next_joint = lerp(a.next_joint, b.next_joint, t);
+    out.width = lerp(a.width, b.width, t);
+    out.rotation = nlerp(a.rotation, b.rotation, t);
+    return out;
+}
+
+// Blends every continuous field; ids, flags and type come from the nearer frame
+void lerp(const LEAP_HAND& a, const LEAP_HAND& b, float t, LEAP_HAND& out) {
+    out = t < 0.5f ? a : b;
+    out.confidence = lerp(a.confidence, b.confidence, t);
+    out.pinch_distance = lerp(a.pinch_distance, b.pinch_distance, t);
+    out.grab_angle = lerp(a.grab_angle, b.grab_angle, t);
+    out.pinch_strength = lerp(a.pinch_strength, b.pinch_strength, t);
+    out.grab_strength = lerp(a.grab_strength, b.grab_strength, t);
+    out.palm.position = lerp(a.palm.position, b.palm.position, t);
+    out.palm.stabilized_position = lerp(a.palm.stabilized_position, b.palm.stabilized_position, t);
+    out.palm.velocity = lerp(a.palm.velocity, b.palm.velocity, t);
+    out.palm.normal = lerp(a.palm.normal, b.palm.normal, t);
+    out.palm.width = lerp(a.palm.width, b.palm.width, t);
+    out.palm.direction = lerp(a.palm.direction, b.palm.direction, t);
+    out.palm.orientation = nlerp(a.palm.orientation, b.palm.orientation, t);
+    for (int d = 0; d < 5; d++) {
+        for (int i = 0; i < 4; i++) {
+            out.digits[d].bones[i] = lerp(a.digits[d].bones[i], b.digits[d].bones[i], t);
+        }
+    }
+    out.arm = lerp(a.arm, b.arm, t);
+}
+
+}  // namespace
+
+// Linear user<->LeapC clock mapping taken from the latest update
+struct _LEAP_CLOCK_REBASER {
+    int64_t leapMinusUser = 0;
+};
+
+// One simulated controller: its frame source, playback clock and history
+struct _LEAP_DEVICE {
+    _LEAP_DEVICE(const StandInConfig& config, uint32_t index);
+
+    const StandInConfig& config;
+    uint32_t id;
+    std::string serial;
+    bool subscribed = false;
+
+    // Storage for the event handed out by the latest poll; valid until the next one
+    LEAP_TRACKING_EVENT trackingEvent = {};
+    LEAP_HAND hands[kMaxHands];
+
+    // Source state
+    std::ifstream recording;
+    std::streampos firstRecord;
+    int64_t recordingOffset = 0;      // added to looped recording timestamps
+    int64_t lastSourceTimestamp = 0;
+    SyntheticHand rightHand;
+    SyntheticHand leftHand;
+
+    // Playback clock
+    bool started = false;
+    int64_t playbackStart = 0;
+    int64_t sourceStart = 0;
+    uint64_t delivered = 0;
+    bool finished = false;
+
+    // Pending frame, loaded ahead of its due time
+    bool havePending = false;
+    int64_t pendingSourceTimestamp = 0;
+    LEAP_TRACKING_EVENT pendingEvent = {};
+    LEAP_HAND pendingHands[kMaxHands];
+
+    // Delivered frames, oldest first once full; written by the polling thread,
+    // read by whichever thread interpolates
+    std::mutex historyMutex;
+    HistoryFrame history[kHistoryFrames];
+    uint64_t historyCount = 0;
+
+    bool openRecording();
+    // Loads the next frame if none is pending; false once the source is exhausted
+    bool ready();
+    int64_t dueTime() const;
+    void emit();
+    void remember(const LEAP_TRACKING_EVENT& event);
+    // Finds the frames either side of timestamp and the blend factor between them
+    eLeapRS bracket(int64_t timestamp, const HistoryFrame*& before, const HistoryFrame*& after, float& t) const;
+
+    bool loadNext();
+    bool loadFromRecording();
+    void loadSynthetic();
+    void report() const;
+};
+
+struct _LEAP_CONNECTION {
+    StandInConfig config;
+    bool multiDeviceAware = false;
+    bool opened = false;
+    bool connectionAnnounced = false;
+    size_t devicesAnnounced = 0;
+    bool policyEventPending = false;
+    uint64_t policyFlags = 0;
+    LEAP_ALLOCATOR allocator = {};
+    std::vector<std::unique_ptr<_LEAP_DEVICE>> devices;
+
+    // Storage for the event handed out by the latest poll; valid until the next one
+    LEAP_CONNECTION_EVENT connectionEvent = {};
+    LEAP_DEVICE_EVENT deviceEvent = {};
+    LEAP_POLICY_EVENT policyEvent = {};
+
+    bool delivers(const _LEAP_DEVICE& device) const {
+        return multiDeviceAware ? device.subscribed : device.id == devices.front()->id;
+    }
+};
+
+_LEAP_DEVICE::_LEAP_DEVICE(const StandInConfig& config, uint32_t index)
+    : config(config), id(index + 1),
+      rightHand(eLeapHandType_Right, 1 + 2 * index, 0.37 * index),
+      leftHand(eLeapHandType_Left, 2 + 2 * index, 0.7 + 0.37 * index)
+{
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "STANDIN%04u", id);
+    serial = buffer;
+}
+
+bool _LEAP_DEVICE::openRecording() {
+    if (config.source == "synthetic") {
+        return true;
+    }
+    recording.open(config.source, std::ifstream::in | std::ifstream::binary);
+    FrameRecordingHeader header;
+    if (!recording.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != FRAME_RECORDING_MAGIC || header.version != FRAME_RECORDING_VERSION ||
+        header.handSize != sizeof(LEAP_HAND)) {
+        return false;
+    }
+    firstRecord = recording.tellg();
+    return true;
+}
+
+bool _LEAP_DEVICE::ready() {
+    if (!finished && !havePending) {
+        havePending = loadNext();
+        if (!havePending) {
+            finished = true;
+            report();
+        }
+    }
+    if (finished) {
+        return false;
+    }
+    if (!started) {
+        started = true;
+        playbackStart = steadyMicros();
+        sourceStart = pendingSourceTimestamp;
+    }
+    return true;
+}
+
+int64_t _LEAP_DEVICE::dueTime() const {
+    if (config.speed <= 0) {
+        return playbackStart;
+    }
+    return playbackStart + static_cast<int64_t>((pendingSourceTimestamp - sourceStart) / config.speed);
+}
+
+void _LEAP_DEVICE::emit() {
+    havePending = false;
+    std::memcpy(hands, pendingHands, pendingEvent.nHands * sizeof(LEAP_HAND));
+    trackingEvent = pendingEvent;
+    trackingEvent.pHands = hands;
+    trackingEvent.info.frame_id = static_cast<int64_t>(delivered);
+    trackingEvent.tracking_frame_id = static_cast<int64_t>(delivered);
+    // Stamp with the emission time so capture-to-output latency is measurable
+    trackingEvent.info.timestamp = steadyMicros();
+    delivered++;
+    remember(trackingEvent);
+}
+
+bool _LEAP_DEVICE::loadNext() {
+    if (config.frameLimit > 0 && delivered >= config.frameLimit) {
+        return false;
+    }
+    if (config.source == "synthetic") {
+        loadSynthetic();
+        return true;
+    }
+    return loadFromRecording();
+}
+
+void _LEAP_DEVICE::loadSynthetic() {
+    pendingSourceTimestamp = static_cast<int64_t>(delivered * 1e6 / config.fps);
+    double seconds = pendingSourceTimestamp / 1e6;
+    rightHand.generate(seconds, pendingHands[0]);
+    if (config.hands > 1) {
+        leftHand.generate(seconds, pendingHands[1]);
+    }
+    pendingEvent.nHands = config.hands;
+    pendingEvent.framerate = static_cast<float>(config.fps);
+}
+
+bool _LEAP_DEVICE::loadFromRecording() {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        FrameRecordingEntry entry;
+        if (recording.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+            uint32_t stored = std::min(entry.nHands, kMaxHands);
+            recording.read(reinterpret_cast<char*>(pendingHands), stored * sizeof(LEAP_HAND));
+            recording.seekg((entry.nHands - stored) * sizeof(LEAP_HAND), std::ios::cur);
+            if (recording) {
+                pendingSourceTimestamp = entry.timestamp + recordingOffset;
+                lastSourceTimestamp = pendingSourceTimestamp;
+                pendingEvent.nHands = stored;
+                pendingEvent.framerate = entry.framerate;
+                return true;
+            }
+        }
+        if (!config.loop || delivered == 0) {
+            return false;
+        }
+        // Wrap around, continuing the source clock one frame after the last timestamp
+        recording.clear();
+        recording.seekg(firstRecord);
+        FrameRecordingEntry first;
+        if (!recording.read(reinterpret_cast<char*>(&first), sizeof(first))) {
+            return false;
+        }
+        recording.seekg(firstRecord);
+        recordingOffset = lastSourceTimestamp + 8333 - first.timestamp;
+    }
+    return false;
+}
+
+void _LEAP_DEVICE::remember(const LEAP_TRACKING_EVENT& event) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    HistoryFrame& slot = history[historyCount % kHistoryFrames];
+    slot.event = event;
+    std::memcpy(slot.hands, event.pHands, event.nHands * sizeof(LEAP_HAND));
+    historyCount++;
+}
+
+eLeapRS _LEAP_DEVICE::bracket(int64_t timestamp, const HistoryFrame*& before, const HistoryFrame*& after, float& t) const {
+    if (historyCount == 0) {
+        return eLeapRS_NotAvailable;
+    }
+    uint64_t oldest = historyCount > kHistoryFrames ? historyCount - kHistoryFrames : 0;
+    const HistoryFrame& newest = history[(historyCount - 1) % kHistoryFrames];
+    if (timestamp > newest.event.info.timestamp) {
+        return eLeapRS_NotAvailable;
+    }
+    if (timestamp < history[oldest % kHistoryFrames].event.info.timestamp) {
+        return eLeapRS_TimestampTooEarly;
+    }
+
+    // Walk back from the newest frame to the first one at or before the target
+    for (uint64_t i = historyCount - 1; i > oldest; i--) {
+        const HistoryFrame& previous = history[(i - 1) % kHistoryFrames];
+        if (previous.event.info.timestamp <= timestamp) {
+            before = &previous;
+            after = &history[i % kHistoryFrames];
+            int64_t span = after->event.info.timestamp - before->event.info.timestamp;
+            t = span > 0 ? static_cast<float>(timestamp - before->event.info.timestamp) / span : 0.0f;
+            return eLeapRS_Success;
+        }
+    }
+    before = after = &history[oldest % kHistoryFrames];
+    t = 0.0f;
+    return eLeapRS_Success;
+}
+
+void _LEAP_DEVICE::report() const {
+    double seconds = (steadyMicros() - playbackStart) / 1e6;
+    std::cerr << "LeapC stand-in: " << serial << " delivered " << delivered << " frames in " << seconds << " s ("
+              << (seconds > 0 ? delivered / seconds : 0.0) << " frames/s)" << std::endl;
+}
+
+extern "C" {
+
+int64_t LeapGetNow(void) {
+    return steadyMicros();
+}
+
+eLeapRS LeapCreateConnection(const LEAP_CONNECTION_CONFIG* pConfig, LEAP_CONNECTION* phConnection) {
+    if (!phConnection) {
+        return eLeapRS_InvalidArgument;
+    }
+    LEAP_CONNECTION connection = new _LEAP_CONNECTION();
+    connection->config = StandInConfig::fromEnvironment();
+    connection->multiDeviceAware = pConfig && (pConfig->flags & eLeapConnectionConfig_MultiDeviceAware);
+
+    for (uint32_t i = 0; i < connection->config.devices; i++) {
+        connection->devices.push_back(std::make_unique<_LEAP_DEVICE>(connection->config, i));
+        if (!connection->devices.back()->openRecording()) {
+            std::cerr << "LeapC stand-in: cannot replay " << connection->config.source << std::endl;
+            delete connection;
+            *phConnection = nullptr;
+            return eLeapRS_InvalidArgument;
+        }
+    }
+
+    *phConnection = connection;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapOpenConnection(LEAP_CONNECTION hConnection) {
+    if (!hConnection) {
+        return eLeapRS_InvalidArgument;
+    }
+    hConnection->opened = true;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapSetAllocator(LEAP_CONNECTION hConnection, const LEAP_ALLOCATOR* allocator) {
+    if (!hConnection || !allocator) {
+        return eLeapRS_InvalidArgument;
+    }
+    hConnection->allocator = *allocator;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapSetPolicyFlags(LEAP_CONNECTION hConnection, uint64_t set, uint64_t clear) {
+    if (!hConnection) {
+        return eLeapRS_InvalidArgument;
+    }
+    hConnection->policyFlags = (hConnection->policyFlags | set) & ~clear;
+    hConnection->policyEventPending = true;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapPollConnection(LEAP_CONNECTION hConnection, uint32_t timeout, LEAP_CONNECTION_MESSAGE* evt) {
+    if (!hConnection || !evt) {
+        return eLeapRS_InvalidArgument;
+    }
+    if (!hConnection->opened) {
+        return eLeapRS_NotConnected;
+    }
+
+    LEAP_CONNECTION c = hConnection;
+    std::memset(evt, 0, sizeof(*evt));
+    evt->size = sizeof(*evt);
+
+    if (!c->connectionAnnounced) {
+        c->connectionAnnounced = true;
+        evt->type = eLeapEventType_Connection;
+        evt->connection_event = &c->connectionEvent;
+        return eLeapRS_Success;
+    }
+
+    if (c->policyEventPending) {
+        c->policyEventPending = false;
+        c->policyEvent.current_policy = static_cast<uint32_t>(c->policyFlags);
+        evt->type = eLeapEventType_Policy;
+        evt->policy_event = &c->policyEvent;
+        return eLeapRS_Success;
+    }
+
+    if (c->devicesAnnounced < c->devices.size()) {
+        _LEAP_DEVICE& device = *c->devices[c->devicesAnnounced++];
+        c->deviceEvent.device.handle = &device;
+        c->deviceEvent.device.id = device.id;
+        c->deviceEvent.status = eLeapDeviceStatus_Streaming;
+        evt->type = eLeapEventType_Device;
+        evt->device_event = &c->deviceEvent;
+        return eLeapRS_Success;
+    }
+
+    // Deliver the earliest due frame among the devices this client receives
+    _LEAP_DEVICE* next = nullptr;
+    for (auto& device : c->devices) {
+        if (c->delivers(*device) && device->ready() &&
+            (!next || device->dueTime() < next->dueTime() ||
+             (device->dueTime() == next->dueTime() && device->delivered < next->delivered))) {
+            next = device.get();
+        }
+    }
+
+    if (!next) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min<uint32_t>(timeout, 100)));
+        return eLeapRS_Timeout;
+    }
+
+    if (c->config.speed > 0) {
+        int64_t due = next->dueTime();
+        int64_t now = steadyMicros();
+        if (due - now > int64_t(timeout) * 1000) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+            return eLeapRS_Timeout;
+        }
+        if (due > now) {
+            std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+        }
+    }
+
+    next->emit();
+    evt->type = eLeapEventType_Tracking;
+    evt->device_id = next->id;
+    evt->tracking_event = &next->trackingEvent;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapGetDeviceList(LEAP_CONNECTION hConnection, LEAP_DEVICE_REF* pArray, uint32_t* pnArray) {
+    if (!hConnection || !pnArray) {
+        return eLeapRS_InvalidArgument;
+    }
+    uint32_t count = static_cast<uint32_t>(hConnection->devices.size());
+    if (!pArray) {
+        *pnArray = count;
+        return eLeapRS_Success;
+    }
+    if (*pnArray < count) {
+        *pnArray = count;
+        return eLeapRS_InsufficientBuffer;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        pArray[i].handle = hConnection->devices[i].get();
+        pArray[i].id = hConnection->devices[i]->id;
+    }
+    *pnArray = count;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapOpenDevice(LEAP_DEVICE_REF rDevice, LEAP_DEVICE* phDevice) {
+    if (!rDevice.handle || !phDevice) {
+        return eLeapRS_InvalidArgument;
+    }
+    *phDevice = static_cast<LEAP_DEVICE>(rDevice.handle);
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapSubscribeEvents(LEAP_CONNECTION hConnection, LEAP_DEVICE hDevice) {
+    if (!hConnection || !hDevice) {
+        return eLeapRS_InvalidArgument;
+    }
+    hDevice->subscribed = true;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapGetDeviceInfo(LEAP_DEVICE hDevice, LEAP_DEVICE_INFO* info) {
+    if (!hDevice || !info) {
+        return eLeapRS_InvalidArgument;
+    }
+    // As in LeapC, a short serial buffer reports the length needed
+    uint32_t needed = static_cast<uint32_t>(hDevice->serial.size() + 1);
+    if (!info->serial || info->serial_length < needed) {
+        info->serial_length = needed;
+        return eLeapRS_InsufficientBuffer;
+    }
+    std::memcpy(info->serial, hDevice->serial.c_str(), needed);
+    info->serial_length = needed;
+    info->status = eLeapDeviceStatus_Streaming;
+    info->pid = eLeapDevicePID_LMC2;
+    return eLeapRS_Success;
+}
+
+void LeapCloseDevice(LEAP_DEVICE hDevice) {
+    // Devices belong to their connection and are freed with it
+    (void)hDevice;
+}
+
+eLeapRS LeapGetFrameSizeEx(LEAP_CONNECTION hConnection, LEAP_DEVICE hDevice, int64_t timestamp, uint64_t* pncbEvent) {
+    if (!hConnection || !hDevice || !pncbEvent) {
+        return eLeapRS_InvalidArgument;
+    }
+    std::lock_guard<std::mutex> lock(hDevice->historyMutex);
+    const HistoryFrame* before = nullptr;
+    const HistoryFrame* after = nullptr;
+    float t = 0;
+    eLeapRS result = hDevice->bracket(timestamp, before, after, t);
+    if (result != eLeapRS_Success) {
+        return result;
+    }
+    const HistoryFrame* nearer = t < 0.5f ? before : after;
+    *pncbEvent = sizeof(LEAP_TRACKING_EVENT) + nearer->event.nHands * sizeof(LEAP_HAND);
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapInterpolateFrameEx(LEAP_CONNECTION hConnection, LEAP_DEVICE hDevice, int64_t timestamp, LEAP_TRACKING_EVENT* pEvent, uint64_t ncbEvent) {
+    if (!hConnection || !hDevice || !pEvent) {
+        return eLeapRS_InvalidArgument;
+    }
+    std::lock_guard<std::mutex> lock(hDevice->historyMutex);
+    const HistoryFrame* before = nullptr;
+    const HistoryFrame* after = nullptr;
+    float t = 0;
+    eLeapRS result = hDevice->bracket(timestamp, before, after, t);
+    if (result != eLeapRS_Success) {
+        return result;
+    }
+
+    // As in LeapC, the hands follow the event header in the caller's buffer
+    const HistoryFrame* nearer = t < 0.5f ? before : after;
+    if (ncbEvent < sizeof(LEAP_TRACKING_EVENT) + nearer->event.nHands * sizeof(LEAP_HAND)) {
+        return eLeapRS_InsufficientBuffer;
+    }
+    *pEvent = nearer->event;
+    pEvent->info.timestamp = timestamp;
+    pEvent->framerate = lerp(before->event.framerate, after->event.framerate, t);
+    pEvent->pHands = reinterpret_cast<LEAP_HAND*>(pEvent + 1);
+
+    // Blend hands present in both frames; a hand that appears or vanishes comes from the nearer one
+    for (uint32_t h = 0; h < nearer->event.nHands; h++) {
+        const LEAP_HAND& hand = nearer->hands[h];
+        const HistoryFrame* other = nearer == before ? after : before;
+        const LEAP_HAND* match = nullptr;
+        for (uint32_t o = 0; o < other->event.nHands; o++) {
+            if (other->hands[o].id == hand.id) {
+                match = &other->hands[o];
+            }
+        }
+        if (!match) {
+            pEvent->pHands[h] = hand;
+        } else if (nearer == before) {
+            lerp(hand, *match, t, pEvent->pHands[h]);
+        } else {
+            lerp(*match, hand, t, pEvent->pHands[h]);
+        }
+    }
+    return eLeapRS_Success;
+}
+
+// The non-Ex calls act on the first device, as LeapC does without LeapSetPrimaryDevice
+eLeapRS LeapGetFrameSize(LEAP_CONNECTION hConnection, int64_t timestamp, uint64_t* pncbEvent) {
+    if (!hConnection) {
+        return eLeapRS_InvalidArgument;
+    }
+    return LeapGetFrameSizeEx(hConnection, hConnection->devices.front().get(), timestamp, pncbEvent);
+}
+
+eLeapRS LeapInterpolateFrame(LEAP_CONNECTION hConnection, int64_t timestamp, LEAP_TRACKING_EVENT* pEvent, uint64_t ncbEvent) {
+    if (!hConnection) {
+        return eLeapRS_InvalidArgument;
+    }
+    return LeapInterpolateFrameEx(hConnection, hConnection->devices.front().get(), timestamp, pEvent, ncbEvent);
+}
+
+eLeapRS LeapCreateClockRebaser(LEAP_CLOCK_REBASER* phClockRebaser) {
+    if (!phClockRebaser) {
+        return eLeapRS_InvalidArgument;
+    }
+    *phClockRebaser = new _LEAP_CLOCK_REBASER();
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapUpdateRebase(LEAP_CLOCK_REBASER hClockRebaser, int64_t userClock, int64_t leapClock) {
+    if (!hClockRebaser) {
+        return eLeapRS_InvalidArgument;
+    }
+    hClockRebaser->leapMinusUser = leapClock - userClock;
+    return eLeapRS_Success;
+}
+
+eLeapRS LeapRebaseClock(LEAP_CLOCK_REBASER hClockRebaser, int64_t userClock, int64_t* pLeapClock) {
+    if (!hClockRebaser || !pLeapClock) {
+        return eLeapRS_InvalidArgument;
+    }
+    *pLeapClock = userClock + hClockRebaser->leapMinusUser;
+    return eLeapRS_Success;
+}
+
+void LeapDestroyClockRebaser(LEAP_CLOCK_REBASER hClockRebaser) {
+    delete hClockRebaser;
+}
+
+void LeapCloseConnection(LEAP_CONNECTION hConnection) {
+    if (hConnection) {
+        hConnection->opened = false;
+    }
+}
+
+void LeapDestroyConnection(LEAP_CONNECTION hConnection) {
+    if (hConnection) {
+        for (auto& device : hConnection->devices) {
+            if (device->started && !device->finished) {
+                device->report();
+            }
+        }
+    }
+    delete hConnection;
+}
+
+}  // extern "C"
+
+// end of LeapCStandIn.cpp //
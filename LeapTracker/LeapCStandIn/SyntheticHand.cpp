@@ -0,0 +1,229 @@
+//
+//  SyntheticHand.cpp
+//  LeapTracker
+//
+#include "SyntheticHand.hpp"
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const float kDegToRad = static_cast<float>(M_PI / 180.0);
+
+LEAP_VECTOR makeVector(float x, float y, float z) {
+    LEAP_VECTOR v;
+    v.x = x;
+    v.y = y;
+    v.z = z;
+    return v;
+}
+
+LEAP_VECTOR add(const LEAP_VECTOR& a, const LEAP_VECTOR& b) {
+    return makeVector(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+LEAP_VECTOR scale(const LEAP_VECTOR& a, float s) {
+    return makeVector(a.x * s, a.y * s, a.z * s);
+}
+
+LEAP_VECTOR normalise(const LEAP_VECTOR& a) {
+    float length = std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+    return length > 0 ? scale(a, 1.0f / length) : a;
+}
+
+LEAP_QUATERNION makeQuaternion(float x, float y, float z, float w) {
+    LEAP_QUATERNION q;
+    q.x = x;
+    q.y = y;
+    q.z = z;
+    q.w = w;
+    return q;
+}
+
+LEAP_QUATERNION multiply(const LEAP_QUATERNION& a, const LEAP_QUATERNION& b) {
+    return makeQuaternion(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                          a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                          a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+LEAP_QUATERNION axisAngle(const LEAP_VECTOR& axis, float angle) {
+    float s = std::sin(angle * 0.5f);
+    return makeQuaternion(axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f));
+}
+
+LEAP_VECTOR rotate(const LEAP_QUATERNION& q, const LEAP_VECTOR& v) {
+    LEAP_QUATERNION p = makeQuaternion(v.x, v.y, v.z, 0);
+    LEAP_QUATERNION conj = makeQuaternion(-q.x, -q.y, -q.z, q.w);
+    LEAP_QUATERNION r = multiply(multiply(q, p), conj);
+    return makeVector(r.x, r.y, r.z);
+}
+
+// Shortest-arc rotation taking the bone's rest direction (-Z) onto dir
+LEAP_QUATERNION fromForward(const LEAP_VECTOR& dir) {
+    LEAP_VECTOR forward = makeVector(0, 0, -1);
+    LEAP_VECTOR axis = makeVector(forward.y * dir.z - forward.z * dir.y,
+                                  forward.z * dir.x - forward.x * dir.z,
+                                  forward.x * dir.y - forward.y * dir.x);
+    float dot = forward.x * dir.x + forward.y * dir.y + forward.z * dir.z;
+    LEAP_QUATERNION q = makeQuaternion(axis.x, axis.y, axis.z, 1.0f + dot);
+    float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (length < 1e-6f) {
+        return makeQuaternion(0, 1, 0, 0);
+    }
+    return makeQuaternion(q.x / length, q.y / length, q.z / length, q.w / length);
+}
+
+struct FingerShape {
+    float baseX;
+    float lengths[3];  // proximal, intermediate, distal
+    float widths[4];
+};
+
+// Right hand, palm down, fingers pointing along -Z, thumb on the -X side
+const FingerShape kFingers[4] = {
+    { -22.0f, { 39.0f, 22.0f, 16.0f }, { 20.0f, 18.0f, 16.0f, 14.0f } },  // index
+    {  -2.0f, { 44.0f, 26.0f, 17.0f }, { 20.0f, 18.0f, 16.0f, 14.0f } },  // middle
+    {  17.0f, { 41.0f, 25.0f, 17.0f }, { 19.0f, 17.0f, 15.0f, 13.0f } },  // ring
+    {  33.0f, { 32.0f, 18.0f, 15.0f }, { 17.0f, 15.0f, 13.0f, 12.0f } },  // pinky
+};
+
+// Maximum flexion at MCP, PIP and DIP when the fist is fully closed
+const float kMaxFlexion[3] = { 80.0f, 100.0f, 70.0f };
+
+const float kPalmToWrist = 55.0f;
+const float kForearmLength = 250.0f;
+
+}  // namespace
+
+SyntheticHand::SyntheticHand(eLeapHandType type, uint32_t id, double phaseSeconds)
+    : type(type), id(id), phase(phaseSeconds) {}
+
+void SyntheticHand::generate(double seconds, LEAP_HAND& hand) const {
+    double t = seconds + phase;
+    float flex = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * 0.4 * t));
+    float roll = static_cast<float>(60.0 * std::sin(2.0 * M_PI * 0.15 * t)) * kDegToRad;
+    float pitch = static_cast<float>(35.0 * std::sin(2.0 * M_PI * 0.25 * t)) * kDegToRad;
+    LEAP_VECTOR wrist = makeVector(static_cast<float>(60.0 + 20.0 * std::sin(2.0 * M_PI * 0.1 * t)),
+                                   static_cast<float>(200.0 + 15.0 * std::sin(2.0 * M_PI * 0.2 * t)),
+                                   0.0f);
+
+    LEAP_QUATERNION armRotation = axisAngle(makeVector(0, 0, 1), roll);
+    LEAP_QUATERNION handRotation = multiply(armRotation, axisAngle(makeVector(1, 0, 0), pitch));
+
+    // Hand-local points are relative to the palm centre
+    auto toWorld = [&](const LEAP_VECTOR& local) {
+        return add(wrist, rotate(handRotation, add(local, makeVector(0, 0, -kPalmToWrist))));
+    };
+    // rotationLocal turns the hand's -Z onto the bone direction; it is built
+    // from the joint rotations so it stays continuous as fingers curl past 180
+    auto makeBone = [&](const LEAP_VECTOR& prevLocal, const LEAP_VECTOR& nextLocal, const LEAP_QUATERNION& rotationLocal, float width) {
+        LEAP_BONE bone;
+        bone.prev_joint = toWorld(prevLocal);
+        bone.next_joint = toWorld(nextLocal);
+        bone.width = width;
+        bone.rotation = multiply(handRotation, rotationLocal);
+        return bone;
+    };
+
+    hand = LEAP_HAND();
+    hand.id = id;
+    hand.flags = 0;
+    hand.type = eLeapHandType_Right;
+    hand.confidence = 1.0f;
+    hand.visible_time = static_cast<uint64_t>(seconds * 1e6);
+
+    hand.palm.position = toWorld(makeVector(0, 0, 0));
+    hand.palm.stabilized_position = hand.palm.position;
+    hand.palm.velocity = makeVector(0, 0, 0);
+    hand.palm.normal = rotate(handRotation, makeVector(0, -1, 0));
+    hand.palm.direction = rotate(handRotation, makeVector(0, 0, -1));
+    hand.palm.width = 85.0f;
+    hand.palm.orientation = handRotation;
+
+    hand.arm.prev_joint = add(wrist, rotate(armRotation, makeVector(0, 0, kForearmLength)));
+    hand.arm.next_joint = wrist;
+    hand.arm.width = 60.0f;
+    hand.arm.rotation = armRotation;
+
+    // Thumb: zero-length metacarpal as LeapC reports it, sweeping across the palm as the fist closes
+    {
+        LEAP_DIGIT& thumb = hand.thumb;
+        thumb.finger_id = id * 10;
+        LEAP_VECTOR joint = makeVector(-25.0f, -5.0f, 35.0f);
+        float yaw = 45.0f * kDegToRad;
+        float dip = 0.0f;
+        const float thumbLengths[4] = { 0.0f, 32.0f, 28.0f, 22.0f };
+        const float thumbYaw[4] = { 0.0f, 25.0f, 35.0f, 30.0f };
+        const float thumbDip[4] = { 0.0f, 10.0f, 15.0f, 20.0f };
+        for (int b = 0; b < 4; b++) {
+            yaw += flex * thumbYaw[b] * kDegToRad;
+            dip += flex * thumbDip[b] * kDegToRad;
+            LEAP_VECTOR dir = normalise(makeVector(-std::cos(yaw) * std::cos(dip), -std::sin(dip), -std::sin(yaw) * std::cos(dip)));
+            LEAP_VECTOR next = add(joint, scale(dir, thumbLengths[b]));
+            LEAP_QUATERNION rotation = multiply(axisAngle(makeVector(0, 1, 0), static_cast<float>(M_PI / 2) - yaw),
+                                                axisAngle(makeVector(1, 0, 0), -dip));
+            thumb.bones[b] = makeBone(joint, next, rotation, 20.0f - 2.0f * b);
+            joint = next;
+        }
+        thumb.is_extended = flex < 0.5f;
+    }
+
+    for (int f = 0; f < 4; f++) {
+        const FingerShape& shape = kFingers[f];
+        LEAP_DIGIT& digit = hand.digits[f + 1];
+        digit.finger_id = id * 10 + f + 1;
+
+        LEAP_VECTOR base = makeVector(shape.baseX * 0.6f, 0.0f, 45.0f);
+        LEAP_VECTOR knuckle = makeVector(shape.baseX, 0.0f, -20.0f);
+        LEAP_VECTOR metacarpalDir = normalise(add(knuckle, scale(base, -1.0f)));
+        digit.metacarpal = makeBone(base, knuckle, fromForward(metacarpalDir), shape.widths[0]);
+
+        LEAP_VECTOR joint = knuckle;
+        float bend = 0.0f;
+        for (int b = 0; b < 3; b++) {
+            bend += flex * kMaxFlexion[b] * kDegToRad;
+            LEAP_VECTOR dir = makeVector(0.0f, -std::sin(bend), -std::cos(bend));
+            LEAP_VECTOR next = add(joint, scale(dir, shape.lengths[b]));
+            digit.bones[b + 1] = makeBone(joint, next, axisAngle(makeVector(1, 0, 0), -bend), shape.widths[b + 1]);
+            joint = next;
+        }
+        digit.is_extended = flex < 0.5f;
+    }
+
+    LEAP_VECTOR thumbTip = hand.thumb.distal.next_joint;
+    LEAP_VECTOR indexTip = hand.index.distal.next_joint;
+    LEAP_VECTOR pinch = add(thumbTip, scale(indexTip, -1.0f));
+    hand.pinch_distance = std::sqrt(pinch.x * pinch.x + pinch.y * pinch.y + pinch.z * pinch.z);
+    hand.grab_angle = flex * static_cast<float>(M_PI);
+    hand.pinch_strength = flex;
+    hand.grab_strength = flex;
+
+    if (type == eLeapHandType_Left) {
+        // Mirror across the YZ plane
+        auto mirrorVector = [](LEAP_VECTOR& v) { v.x = -v.x; };
+        auto mirrorRotation = [](LEAP_QUATERNION& q) { q.y = -q.y; q.z = -q.z; };
+        auto mirrorBone = [&](LEAP_BONE& bone) {
+            mirrorVector(bone.prev_joint);
+            mirrorVector(bone.next_joint);
+            mirrorRotation(bone.rotation);
+        };
+        hand.type = eLeapHandType_Left;
+        mirrorVector(hand.palm.position);
+        mirrorVector(hand.palm.stabilized_position);
+        mirrorVector(hand.palm.normal);
+        mirrorVector(hand.palm.direction);
+        mirrorRotation(hand.palm.orientation);
+        mirrorBone(hand.arm);
+        for (LEAP_DIGIT& digit : hand.digits) {
+            for (LEAP_BONE& bone : digit.bones) {
+                mirrorBone(bone);
+            }
+        }
+    }
+}
+
+// end of SyntheticHand.cpp //
@@ -0,0 +1,29 @@
+//
+//  SyntheticHand.hpp
+//  LeapTracker
+//
+//  Procedural hand motion for the LeapC stand-in: the hand repeatedly makes
+//  a fist, pronates/supinates and flexes at the wrist, producing a
+//  kinematically consistent LEAP_HAND (joint positions and bone rotations)
+//  at any point in time.
+//
+#ifndef SyntheticHand_hpp
+#define SyntheticHand_hpp
+
+#include "LeapC.h"
+#include <cstdint>
+
+class SyntheticHand {
+public:
+    SyntheticHand(eLeapHandType type, uint32_t id, double phaseSeconds);
+
+    // Fills hand with the pose at the given time since the start of playback
+    void generate(double seconds, LEAP_HAND& hand) const;
+
+private:
+    eLeapHandType type;
+    uint32_t id;
+    double phase;
+};
+
+#endif /* SyntheticHand_hpp */
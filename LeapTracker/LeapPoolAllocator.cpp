@@ -0,0 +1,148 @@
+//
+//  LeapPoolAllocator.cpp
+//  LeapTracker
+//
+#include "LeapPoolAllocator.hpp"
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+// Header placed in front of every block; padded so the payload keeps
+// max_align_t alignment.
+struct alignas(alignof(std::max_align_t)) LeapPoolAllocator::BlockHeader {
+    BlockHeader* next;
+    uint32_t sizeClass;
+    uint32_t typeHint;
+    uint32_t size;  // bytes requested, only meaningful for oversize blocks
+};
+
+LeapPoolAllocator::LeapPoolAllocator()
+    : freeLists(), liveBytes(0), peakBytes(0), reservedBytes(0),
+      allocations(0), deallocations(0), poolHits(0), poolMisses(0)
+{
+    allocator.allocate = &LeapPoolAllocator::allocateCallback;
+    allocator.deallocate = &LeapPoolAllocator::deallocateCallback;
+    allocator.state = this;
+}
+
+LeapPoolAllocator::~LeapPoolAllocator() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    for (uint32_t hint = 0; hint < kTypeHints; hint++) {
+        for (uint32_t sizeClass = 0; sizeClass < kSizeClasses; sizeClass++) {
+            BlockHeader* block = freeLists[hint][sizeClass];
+            while (block) {
+                BlockHeader* next = block->next;
+                std::free(block);
+                block = next;
+            }
+        }
+    }
+}
+
+uint32_t LeapPoolAllocator::sizeClassFor(uint32_t size) {
+    uint32_t sizeClass = 0;
+    uint64_t classBytes = uint64_t(1) << kMinClassShift;
+    while (classBytes < size) {
+        classBytes <<= 1;
+        if (++sizeClass == kSizeClasses) {
+            return kOversizeClass;
+        }
+    }
+    return sizeClass;
+}
+
+size_t LeapPoolAllocator::blockBytes(uint32_t sizeClass, uint32_t size) {
+    if (sizeClass == kOversizeClass) {
+        return size;
+    }
+    return size_t(1) << (sizeClass + kMinClassShift);
+}
+
+void* LeapPoolAllocator::allocate(uint32_t size, eLeapAllocatorType typeHint) {
+    uint32_t sizeClass = sizeClassFor(size);
+    uint32_t hint = static_cast<uint32_t>(typeHint) < kTypeHints ? static_cast<uint32_t>(typeHint) : 0;
+    size_t bytes = blockBytes(sizeClass, size);
+
+    BlockHeader* block = nullptr;
+    if (sizeClass != kOversizeClass) {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        block = freeLists[hint][sizeClass];
+        if (block) {
+            freeLists[hint][sizeClass] = block->next;
+        }
+    }
+
+    if (block) {
+        poolHits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        block = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + bytes));
+        if (!block) {
+            return nullptr;
+        }
+        block->sizeClass = sizeClass;
+        block->typeHint = hint;
+        block->size = size;
+        poolMisses.fetch_add(1, std::memory_order_relaxed);
+        reservedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    block->next = nullptr;
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+
+    return block + 1;
+}
+
+void LeapPoolAllocator::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    BlockHeader* block = static_cast<BlockHeader*>(ptr) - 1;
+    size_t bytes = blockBytes(block->sizeClass, block->size);
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+    liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+
+    if (block->sizeClass == kOversizeClass) {
+        reservedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+        std::free(block);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    block->next = freeLists[block->typeHint][block->sizeClass];
+    freeLists[block->typeHint][block->sizeClass] = block;
+}
+
+LeapPoolAllocator::Stats LeapPoolAllocator::stats() const {
+    Stats s;
+    s.liveBytes = liveBytes.load(std::memory_order_relaxed);
+    s.peakBytes = peakBytes.load(std::memory_order_relaxed);
+    s.reservedBytes = reservedBytes.load(std::memory_order_relaxed);
+    s.allocations = allocations.load(std::memory_order_relaxed);
+    s.deallocations = deallocations.load(std::memory_order_relaxed);
+    s.poolHits = poolHits.load(std::memory_order_relaxed);
+    s.poolMisses = poolMisses.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::string LeapPoolAllocator::describe() const {
+    Stats s = stats();
+    std::stringstream ss;
+    ss << "LeapC allocator: " << s.allocations << " allocations (" << s.poolHits << " pooled, " << s.poolMisses << " new), "
+       << s.liveBytes << " live bytes, " << s.peakBytes << " peak bytes, " << s.reservedBytes << " reserved bytes";
+    return ss.str();
+}
+
+void* LeapPoolAllocator::allocateCallback(uint32_t size, eLeapAllocatorType typeHint, void* state) {
+    return static_cast<LeapPoolAllocator*>(state)->allocate(size, typeHint);
+}
+
+void LeapPoolAllocator::deallocateCallback(void* ptr, void* state) {
+    static_cast<LeapPoolAllocator*>(state)->deallocate(ptr);
+}
+
+// end of LeapPoolAllocator.cpp //
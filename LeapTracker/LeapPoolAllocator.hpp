@@ -0,0 +1,75 @@
+//
+//  LeapPoolAllocator.hpp
+//  LeapTracker
+//
+//  LEAP_ALLOCATOR implementation handed to LeapC through LeapSetAllocator.
+//  Blocks are rounded up to power-of-two size classes and kept on free lists
+//  per eLeapAllocatorType hint, so once a session has warmed up the image and
+//  event buffers LeapC asks for are recycled rather than malloc'd again.
+//
+#ifndef LeapPoolAllocator_hpp
+#define LeapPoolAllocator_hpp
+
+#include "LeapC.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+class LeapPoolAllocator {
+public:
+    struct Stats {
+        uint64_t liveBytes;      // bytes currently handed out to LeapC
+        uint64_t peakBytes;      // high-water mark of liveBytes
+        uint64_t reservedBytes;  // bytes obtained from the system, live or pooled
+        uint64_t allocations;
+        uint64_t deallocations;
+        uint64_t poolHits;       // allocations served from a free list
+        uint64_t poolMisses;     // allocations that had to go to the system
+    };
+
+    LeapPoolAllocator();
+    ~LeapPoolAllocator();
+
+    LeapPoolAllocator(const LeapPoolAllocator&) = delete;
+    LeapPoolAllocator& operator=(const LeapPoolAllocator&) = delete;
+
+    const LEAP_ALLOCATOR* leapAllocator() const { return &allocator; }
+
+    void* allocate(uint32_t size, eLeapAllocatorType typeHint);
+    void deallocate(void* ptr);
+
+    Stats stats() const;
+    std::string describe() const;
+
+private:
+    // 64 B .. 16 MB; anything larger bypasses the pool
+    static const uint32_t kMinClassShift = 6;
+    static const uint32_t kSizeClasses = 19;
+    static const uint32_t kOversizeClass = kSizeClasses;
+    // eLeapAllocatorType values run from 0 to 10
+    static const uint32_t kTypeHints = 11;
+
+    struct BlockHeader;
+
+    LEAP_ALLOCATOR allocator;
+    mutable std::mutex poolMutex;
+    BlockHeader* freeLists[kTypeHints][kSizeClasses];
+
+    std::atomic<uint64_t> liveBytes;
+    std::atomic<uint64_t> peakBytes;
+    std::atomic<uint64_t> reservedBytes;
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> deallocations;
+    std::atomic<uint64_t> poolHits;
+    std::atomic<uint64_t> poolMisses;
+
+    static uint32_t sizeClassFor(uint32_t size);
+    static size_t blockBytes(uint32_t sizeClass, uint32_t size);
+
+    static void* allocateCallback(uint32_t size, eLeapAllocatorType typeHint, void* state);
+    static void deallocateCallback(void* ptr, void* state);
+};
+
+#endif /* LeapPoolAllocator_hpp */
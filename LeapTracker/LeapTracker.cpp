@@ -5,6 +5,7 @@
 //  Created by Fergal Davis on 29/07/2024.
 //
 #include "LeapTracker.hpp"
+#include "FastMath.hpp"
 #include <iostream>
 #include <cmath>
 #include <algorithm> 
@@ -13,6 +14,7 @@
 #include <iomanip>
 #include <thread>
 #include <stdexcept>
+#include <cstring>
 #include <sys/stat.h>
 #include <unistd.h>
 #include "tinyosc.h"
@@ -23,17 +25,86 @@
 
 #define OUTPUT_BUFFER_SIZE 1024
 
+static nlohmann::json writerStatsJson(const AsyncFileWriter::Stats& stats) {
+    return {
+        {"pendingBytes", stats.pendingBytes},
+        {"maxPendingBytes", stats.maxPendingBytes},
+        {"bytesWritten", stats.bytesWritten},
+        {"writes", stats.writes},
+        {"syncs", stats.syncs},
+        {"bufferGrowths", stats.bufferGrowths},
+        {"writeErrors", stats.writeErrors},
+        {"lagMicros", stats.lagMicros},
+        {"maxLagMicros", stats.maxLagMicros},
+        {"rawBytes", stats.rawBytes},
+        {"blocks", stats.blocks},
+        {"parts", stats.parts},
+        {"journalOverruns", stats.journalOverruns}
+    };
+}
+
+static void printWriterStats(const char* name, const AsyncFileWriter::Stats& stats) {
+    std::cout << name << ": " << stats.bytesWritten << " bytes in " << stats.writes << " writes, "
+              << stats.syncs << " syncs, max " << stats.maxPendingBytes << " bytes pending, max lag "
+              << stats.maxLagMicros / 1000.0 << " ms";
+    if (stats.blocks > 0) {
+        std::cout << ", " << stats.rawBytes << " bytes before compression in " << stats.blocks << " blocks";
+    }
+    if (stats.parts > 1) {
+        std::cout << ", " << stats.parts << " parts";
+    }
+    if (stats.journalOverruns > 0) {
+        std::cout << ", " << stats.journalOverruns << " journal overruns";
+    }
+    std::cout << std::endl;
+}
+
+// OSC addresses of one hand's output under a prefix: "/leap" for the
+// single-hand layout, "/leap/left" and "/leap/right" in bimanual mode
+struct HandOscAddresses {
+    std::string tips[5][3];
+    std::string distances[4];
+    std::string metrics[kMetricCount];
+    std::string handPresence;
+
+    explicit HandOscAddresses(const std::string& prefix) {
+        static const char* fingers[5] = {"thumb", "index", "middle", "ring", "pinky"};
+        static const char* axes[3] = {"x", "y", "z"};
+        for (int i = 0; i < 5; i++) {
+            for (int a = 0; a < 3; a++) {
+                tips[i][a] = prefix + "/" + fingers[i] + "_" + axes[a];
+            }
+            if (i > 0) {
+                distances[i - 1] = prefix + "/thumb_" + fingers[i] + "_distance";
+            }
+        }
+        // Metric addresses are registered under "/leap"
+        for (size_t m = 0; m < kMetricCount; m++) {
+            metrics[m] = prefix + std::string(kMetricInfo[m].oscAddress).substr(5);
+        }
+        handPresence = prefix + "/hand_presence";
+    }
+
+    // slot is a handSlot(), or -1 for the single-hand layout
+    static const HandOscAddresses& forSlot(int slot) {
+        static const HandOscAddresses addresses[kHandSlots + 1] = {
+            HandOscAddresses("/leap"), HandOscAddresses("/leap/left"), HandOscAddresses("/leap/right")
+        };
+        return addresses[slot + 1];
+    }
+};
+
 // Helper functions to compute roll, pitch, and yaw
 float computeRoll(const LEAP_VECTOR& normal) {
-    return atan2(normal.y, normal.z) * 180.0 / M_PI;
+    return Trig::atan2(normal.y, normal.z) * 180.0 / M_PI;
 }
 
 float computePitch(const LEAP_VECTOR& direction) {
-    return asin(direction.y) * 180.0 / M_PI;
+    return Trig::asin(direction.y) * 180.0 / M_PI;
 }
 
 float computeYaw(const LEAP_VECTOR& direction) {
-    return atan2(direction.x, direction.z) * 180.0 / M_PI;
+    return Trig::atan2(direction.x, direction.z) * 180.0 / M_PI;
 }
 
 // Helper function to compute wrist angles
@@ -46,7 +117,7 @@ float computeWristFlexionExtension(const LEAP_VECTOR& wrist, const LEAP_VECTOR&
         return 0;  // or some default value
     }
     
-    return std::acos(dot_product / (magnitude_wrist * magnitude_palm)) * 180.0 / M_PI;
+    return Trig::acos(dot_product / (magnitude_wrist * magnitude_palm)) * 180.0 / M_PI;
 }
 
 float computeWristRadialUlnarDeviation(const LEAP_VECTOR& wrist, const LEAP_VECTOR& palm) {
@@ -58,54 +129,51 @@ float computeWristRadialUlnarDeviation(const LEAP_VECTOR& wrist, const LEAP_VECT
         return 0;  // or some default value
     }
     
-    return std::acos(dot_product / (magnitude_wrist * magnitude_palm)) * 180.0 / M_PI;
+    return Trig::acos(dot_product / (magnitude_wrist * magnitude_palm)) * 180.0 / M_PI;
 }
 
 // Constructor
-LeapTracker::LeapTracker(const std::string& clientName, int sessionNumber, const std::string& exerciseName, const char* oscIP, int oscPort, int wsPort)
-    : clientName(clientName), sessionNumber(sessionNumber), exerciseName(exerciseName), oscIP(oscIP), oscPort(oscPort), isTracking(false)
+LeapTracker::LeapTracker(const std::string& clientName, int sessionNumber, const std::string& exerciseName, const char* oscIP, int oscPort, int wsPort,
+                         const LeapTrackerOptions& options)
+    : clientName(clientName), sessionNumber(sessionNumber), exerciseName(exerciseName), oscIP(oscIP), oscPort(oscPort), isTracking(false), options(options)
 {
     try {
-        // Default to current working directory
-        std::string filePath = "./";
-        std::string fileName = (clientName.empty() ? "UnknownClient" : clientName) + "_session" + std::to_string(sessionNumber) + "_" + exerciseName + ".csv";
-        filePath += fileName;
-
-        // Check if file exists and generate a unique filename if necessary
-        while (fileExists(filePath)) {
-            sessionNumber++;
-            filePath = "./" + (clientName.empty() ? "UnknownClient" : clientName) + "_session" + std::to_string(sessionNumber) + "_" + exerciseName + ".csv";
-        }
-
-        std::cout << "Creating log file: " << filePath << std::endl;
-
-        logFile.open(filePath, std::ofstream::out);
-        if (logFile.is_open()) {
-            logFile << "Client Name,Session Number,Exercise Name,Timestamp,Hand,"
-                    << "Thumb X,Thumb Y,Thumb Z,Index X,Index Y,Index Z,Middle X,Middle Y,Middle Z,Ring X,Ring Y,Ring Z,Pinky X,Pinky Y,Pinky Z,"
-                    << "Thumb MCP,Thumb PIP,Thumb DIP,Index MCP,Index PIP,Index DIP,Middle MCP,Middle PIP,Middle DIP,Ring MCP,Ring PIP,Ring DIP,Pinky MCP,Pinky PIP,Pinky DIP,"
-                    << "Wrist X,Wrist Y,Wrist Z,Wrist Flexion,Wrist Extension,Radial Deviation,Ulnar Deviation,"
-                    << "Palm X,Palm Y,Palm Z,Palm Roll,Palm Pitch,Palm Yaw,Hand Roll,Hand Pitch,Hand Yaw,"
-                    << "Thumb-Index Distance,Thumb-Middle Distance,Thumb-Ring Distance,Thumb-Pinky Distance\n";
-            std::cout << "Log file created at: " << filePath << std::endl;
-        } else {
-            std::cerr << "Failed to open log file at: " << filePath << std::endl;
-            throw std::runtime_error("Failed to open log file");
+        if (options.deviceCount < 1) {
+            throw std::invalid_argument("Device count must be at least one");
         }
-
-        // Initialise OSC
-        oscSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-        if (oscSocket == -1) {
-            throw std::runtime_error("Failed to create OSC socket");
+        for (PolicyManager::Stream stream : options.sessionStreams) {
+            policyManager.acquire(stream);
         }
 
-        memset(&oscAddr, 0, sizeof(oscAddr));
-        oscAddr.sin_family = AF_INET;
-        oscAddr.sin_port = htons(oscPort);
-        oscAddr.sin_addr.s_addr = inet_addr(oscIP);
+        // The command-line session, any copies of it for extra controllers, then hosted sessions
+        SessionSpec commandLineSpec;
+        commandLineSpec.clientName = clientName;
+        commandLineSpec.sessionNumber = sessionNumber;
+        commandLineSpec.exerciseName = exerciseName;
+        commandLineSpec.deviceSerial = options.deviceSerial;
 
-        std::cout << "OSC initialised with IP: " << this->oscIP << ", Port: " << this->oscPort << std::endl;
+        std::vector<SessionSpec> specs(options.deviceCount, commandLineSpec);
+        for (size_t i = 1; i < specs.size(); i++) {
+            specs[i].deviceSerial.clear();
+        }
+        specs.insert(specs.end(), options.extraSessions.begin(), options.extraSessions.end());
+
+        // Outputs are opened up front so clients can connect before a controller is attached
+        for (size_t i = 0; i < specs.size(); i++) {
+            sessions.push_back(std::make_unique<TrackingSession>());
+            TrackingSession& session = *sessions.back();
+            session.index = static_cast<int>(i);
+            session.spec = specs[i];
+            if (i > 0 && i < static_cast<size_t>(options.deviceCount)) {
+                session.fileSuffix = "_device" + std::to_string(i);
+            }
+            session.oscPort = oscPort + static_cast<int>(i);
+            initialiseSession(session);
+        }
 
+        sessionManager = std::make_unique<SessionManager>(static_cast<int>(sessions.size()), options.ioThreadCount);
+        std::cout << "OSC initialised with IP: " << this->oscIP << ", Port: " << this->oscPort
+                  << (sessions.size() > 1 ? " (plus session index)" : "") << std::endl;
         initialiseWebSocket(wsPort);
     }
     catch (const std::exception& e) {
@@ -114,51 +182,143 @@ LeapTracker::LeapTracker(const std::string& clientName, int sessionNumber, const
     }
 }
 
+void LeapTracker::initialiseSession(TrackingSession& session) {
+    const SessionSpec& spec = session.spec;
+    session.frameRing = std::make_unique<FrameRing>(options.frameRingCapacity, options.frameRingPolicy);
+    if (options.outputRate > 0) {
+        session.frameResampler = std::make_unique<FrameResampler>(options.outputRate, options.outputDelayMicros);
+        std::cout << "Resampling output to " << options.outputRate << " Hz" << std::endl;
+    }
+    if (!options.frameRecordingPath.empty()) {
+        std::string recordingPath = sessionFileName(options.frameRecordingPath, session.index);
+        if (!session.frameRecorder.open(recordingPath)) {
+            throw std::runtime_error("Failed to open frame recording: " + recordingPath);
+        }
+        std::cout << "Recording frames to: " << recordingPath << std::endl;
+    }
+
+    // Default to current working directory
+    int sessionNumber = spec.sessionNumber;
+    std::string filePath = "./";
+    std::string fileName = (spec.clientName.empty() ? "UnknownClient" : spec.clientName) + "_session" + std::to_string(sessionNumber) + "_" + spec.exerciseName + session.fileSuffix + ".csv";
+    filePath += fileName;
+
+    // Check if file exists and generate a unique filename if necessary; the
+    // binary and compressed logs of a session are named after its CSV path
+    auto logExists = [this](const std::string& csvPath) {
+        for (const std::string& path : { csvPath, sessionFilePathFor(csvPath) }) {
+            if (fileExists(path) || fileExists(path + ".zst")) {
+                return true;
+            }
+        }
+        return false;
+    };
+    while (logExists(filePath)) {
+        sessionNumber++;
+        filePath = "./" + (spec.clientName.empty() ? "UnknownClient" : spec.clientName) + "_session" + std::to_string(sessionNumber) + "_" + spec.exerciseName + session.fileSuffix + ".csv";
+    }
+
+    std::cout << "Creating log file: " << filePath << std::endl;
+
+    session.exercisePipeline = &exercisePipelineFor(spec.exerciseName);
+
+    session.hands = std::make_unique<HandStateTable>(options.filterType);
+    session.statistics = std::make_unique<SessionStatistics>(*session.exercisePipeline,
+                                                             options.jointAngleSource == JointAngleSource::Quaternion);
+    session.eventDetector = std::make_unique<EventDetector>(spec.exerciseName, *session.exercisePipeline);
+
+    session.calibrationPath = PatientCalibration::pathFor(options.calibrationDirectory, spec.clientName);
+    if (session.calibration.load(session.calibrationPath)) {
+        std::cout << "Loaded calibration from: " << session.calibrationPath << std::endl;
+    }
+    if (options.calibrate) {
+        session.calibrationRecorder = std::make_unique<CalibrationRecorder>(*session.exercisePipeline);
+        std::cout << "Calibrating: move through the full range of the exercise; ranges are saved when tracking stops" << std::endl;
+    }
+
+    session.columns = std::make_unique<SessionColumns>(*session.exercisePipeline,
+                                                       options.jointAngleSource == JointAngleSource::Quaternion);
+
+    // The CSV path names the session even when only the binary log is written
+    session.logFilePath = filePath;
+    if (writesCsv(options.logFormat)) {
+        if (session.logFile.open(filePath, options.csvWriter, session.columns->csvHeader())) {
+            std::string rowPrefix = spec.clientName + "," + std::to_string(spec.sessionNumber) + "," + spec.exerciseName + ",";
+            session.csvRow = std::make_unique<RowFormatter>(rowPrefix, session.columns->size() + 1,
+                                                            DEVICE_CLOCK_TIMESTAMP_SIZE, options.csvFloatFormat);
+            std::cout << "Log file created at: " << session.logFile.path() << std::endl;
+        } else {
+            std::cerr << "Failed to open log file at: " << filePath << std::endl;
+            throw std::runtime_error("Failed to open log file");
+        }
+    }
+    if (writesBinary(options.logFormat)) {
+        session.binaryLogPath = sessionFilePathFor(filePath);
+        if (session.binaryLog.open(session.binaryLogPath, spec.clientName, spec.sessionNumber, spec.exerciseName,
+                                   *session.columns, options.csvWriter)) {
+            std::cout << "Binary log file created at: " << session.binaryLog.path() << std::endl;
+        } else {
+            std::cerr << "Failed to open binary log file at: " << session.binaryLogPath << std::endl;
+            throw std::runtime_error("Failed to open binary log file");
+        }
+    }
+
+    // OSC goes out through the shared socket to this session's port
+    memset(&session.oscAddr, 0, sizeof(session.oscAddr));
+    session.oscAddr.sin_family = AF_INET;
+    session.oscAddr.sin_port = htons(session.oscPort);
+    session.oscAddr.sin_addr.s_addr = inet_addr(oscIP.c_str());
+}
+
+// Session 0 keeps the given name; session k gets "_device<k>" before the extension
+std::string LeapTracker::sessionFileName(const std::string& path, int index) const {
+    if (index == 0) {
+        return path;
+    }
+    std::string suffix = "_device" + std::to_string(index);
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
 // Destructor
 LeapTracker::~LeapTracker() {
     stopTracking();
-    if (logFile.is_open()) {
-        logFile.close();
-    }
-    close(oscSocket);
-    if (wsServer) {
-        wsServer->stop_listening();
-        wsServer->stop();
+    if (sessionManager) {
+        sessionManager->stop();
     }
-    if (wsThread.joinable()) {
-        wsThread.join();
+    for (auto& session : sessions) {
+        session->logFile.close();
+        session->binaryLog.close();
     }
 }
 
 void LeapTracker::initialiseWebSocket(int port) {
     try {
-        wsServer = std::make_unique<WsServer>();
-        wsServer->init_asio();
-        wsServer->set_reuse_addr(true);
-
-        wsServer->set_open_handler([this](websocketpp::connection_hdl hdl) {
-            onWebSocketOpen(hdl);
-        });
-
-        wsServer->set_close_handler([this](websocketpp::connection_hdl hdl) {
-            onWebSocketClose(hdl);
-        });
-
-        wsServer->set_message_handler([this](websocketpp::connection_hdl hdl, WsServer::message_ptr msg) {
-            // Handle incoming messages if needed
-        });
-
-        wsServer->listen(port);
-        wsServer->start_accept();
+        SessionManager::Handlers handlers;
+        handlers.open = [this](int session, websocketpp::connection_hdl hdl) {
+            onWebSocketOpen(*sessions[session], hdl);
+        };
+        handlers.close = [this](int session, websocketpp::connection_hdl hdl) {
+            onWebSocketClose(*sessions[session], hdl);
+        };
+        handlers.message = [this](int session, websocketpp::connection_hdl hdl, const std::string& payload) {
+            onWebSocketMessage(*sessions[session], hdl, payload);
+        };
+        handlers.http = [this](int session, const std::string& subpath, WsServer::connection_ptr con) {
+            onHttpRequest(*sessions[session], subpath, con);
+        };
+        sessionManager->listen(port, handlers);
 
-        wsThread = std::thread([this]() {
-            try {
-                wsServer->run();
+        if (sessions.size() > 1) {
+            for (auto& session : sessions) {
+                std::cout << "Session " << session->index << " (" << session->spec.clientName << ", " << session->spec.exerciseName
+                          << "): ws://localhost:" << port << "/session/" << session->index << ", OSC port " << session->oscPort << std::endl;
             }
-            catch (const std::exception& e) {
-                std::cerr << "Error in WebSocket server: " << e.what() << std::endl;
-            }
-        });
+        }
     }
     catch (const std::exception& e) {
         std::cerr << "Error initialising WebSocket: " << e.what() << std::endl;
@@ -167,133 +327,265 @@ void LeapTracker::initialiseWebSocket(int port) {
 }
 
 
-void LeapTracker::onWebSocketOpen(websocketpp::connection_hdl hdl) {
-    wsConnections.insert(hdl);
+void LeapTracker::onWebSocketOpen(TrackingSession& session, websocketpp::connection_hdl hdl) {
+    std::lock_guard<std::mutex> lock(session.wsMutex);
+    session.wsConnections.insert(hdl);
 }
 
-void LeapTracker::onWebSocketClose(websocketpp::connection_hdl hdl) {
-    wsConnections.erase(hdl);
+void LeapTracker::onWebSocketClose(TrackingSession& session, websocketpp::connection_hdl hdl) {
+    std::lock_guard<std::mutex> lock(session.wsMutex);
+    session.wsConnections.erase(hdl);
+    session.wsOutputs.erase(hdl);
+
+    // Drop any streams this client was holding open
+    auto it = session.wsSubscriptions.find(hdl);
+    if (it != session.wsSubscriptions.end()) {
+        for (int i = 0; i < PolicyManager::StreamCount; i++) {
+            if (it->second & (1u << i)) {
+                policyManager.release(static_cast<PolicyManager::Stream>(i));
+            }
+        }
+        session.wsSubscriptions.erase(it);
+    }
 }
 
-void LeapTracker::broadcastWebSocketMessage(const std::string& message) {
-    for (auto& hdl : wsConnections) {
+// Clients can ask for optional LeapC streams with {"subscribe": "background_frames"} / {"unsubscribe": ...},
+// choose between frames and exercise events with {"subscribe": "events"} / {"unsubscribe": "frames"},
+// and ask for the session statistics so far with {"command": "stats"}
+void LeapTracker::onWebSocketMessage(TrackingSession& session, websocketpp::connection_hdl hdl, const std::string& payload) {
+    nlohmann::json request = nlohmann::json::parse(payload, nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        return;
+    }
+
+    if (request.value("command", "") == "stats") {
+        nlohmann::json reply = {{"stats", statisticsReport(session)}};
         try {
-            wsServer->send(hdl, message, websocketpp::frame::opcode::text);
+            sessionManager->server().send(hdl, reply.dump(), websocketpp::frame::opcode::text);
         } catch (const websocketpp::exception& e) {
             std::cerr << "Error sending WebSocket message: " << e.what() << std::endl;
         }
+        return;
+    }
+
+    bool subscribe = request.contains("subscribe");
+    if (!subscribe && !request.contains("unsubscribe")) {
+        return;
+    }
+    const nlohmann::json& name = request[subscribe ? "subscribe" : "unsubscribe"];
+    if (!name.is_string()) {
+        return;
+    }
+    std::string streamName = name.get<std::string>();
+    if (streamName == "frames" || streamName == "events") {
+        uint32_t bit = streamName == "frames" ? TrackingSession::FrameOutput : TrackingSession::EventOutput;
+        std::lock_guard<std::mutex> lock(session.wsMutex);
+        auto it = session.wsOutputs.emplace(hdl, TrackingSession::FrameOutput).first;
+        it->second = subscribe ? (it->second | bit) : (it->second & ~bit);
+        return;
+    }
+    PolicyManager::Stream stream;
+    if (!PolicyManager::parseStream(streamName, stream)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(session.wsMutex);
+    uint32_t& mask = session.wsSubscriptions[hdl];
+    uint32_t bit = 1u << stream;
+    if (subscribe && !(mask & bit)) {
+        mask |= bit;
+        policyManager.acquire(stream);
+    } else if (!subscribe && (mask & bit)) {
+        mask &= ~bit;
+        policyManager.release(stream);
     }
 }
 
-float LeapTracker::calculateMakeAFistMetric(const LEAP_HAND* hand) {
-    float totalFlexion = 0.0f;
-    const LEAP_DIGIT* fingers[] = {&hand->thumb, &hand->index, &hand->middle, &hand->ring, &hand->pinky};
-    
-    for (const LEAP_DIGIT* finger : fingers) {
-        float mcpAngle = calculateAngleBetweenBones(finger->metacarpal, finger->proximal);
-        float pipAngle = calculateAngleBetweenBones(finger->proximal, finger->intermediate);
-        float dipAngle = calculateAngleBetweenBones(finger->intermediate, finger->distal);
-        
-        totalFlexion += mcpAngle + pipAngle + dipAngle;
+void LeapTracker::onHttpRequest(TrackingSession& session, const std::string& subpath, WsServer::connection_ptr con) {
+    if (subpath == "/metrics") {
+        con->set_status(websocketpp::http::status_code::ok);
+        con->append_header("Content-Type", "application/json");
+        con->set_body(getMetricsJson(session.index));
+    } else if (subpath == "/stats") {
+        con->set_status(websocketpp::http::status_code::ok);
+        con->append_header("Content-Type", "application/json");
+        con->set_body(getStatisticsJson(session.index));
+    } else {
+        con->set_status(websocketpp::http::status_code::not_found);
+        con->set_body("Not found\n");
     }
-    
-    // Adjust these values based on observed min/max totalFlexion
-    float minFlexion = 50.0f;  // Adjust this: typical value for an open hand
-    float maxFlexion = 700.0f;  // Fully closed fist (keep this if it works well for closed fist)
-    
-    // Expand the range by adjusting the normalisation
-    float n = (totalFlexion - minFlexion) / (maxFlexion - minFlexion);
-    
-    // Optional: Apply a power function to emphasize lower values
-    //float power = 1.5f; // Adjust this value to fine-tune the curve
-    //n = std::pow(n, power);
-    
-    return std::min(1.0f, std::max(0.0f, n));
 }
 
-float LeapTracker::calculateAngleBetweenBones(const LEAP_BONE& bone1, const LEAP_BONE& bone2) {
-    LEAP_VECTOR vec1 = {
-        bone1.next_joint.x - bone1.prev_joint.x,
-        bone1.next_joint.y - bone1.prev_joint.y,
-        bone1.next_joint.z - bone1.prev_joint.z
+std::string LeapTracker::getMetricsJson(size_t index) {
+    TrackingSession& session = *sessions.at(index);
+    nlohmann::json report = session.metrics.toJson();
+
+    bool bound = session.bound;
+    report["device"] = {
+        {"session", session.index},
+        {"id", bound ? session.deviceId : 0},
+        {"serial", bound ? session.serial : std::string()}
     };
-    LEAP_VECTOR vec2 = {
-        bone2.next_joint.x - bone2.prev_joint.x,
-        bone2.next_joint.y - bone2.prev_joint.y,
-        bone2.next_joint.z - bone2.prev_joint.z
+
+    report["frameRing"] = {
+        {"depth", session.frameRing->size()},
+        {"capacity", session.frameRing->capacity()},
+        {"overflows", session.frameRing->overflowCount()}
     };
-    
-    float dot_product = vec1.x * vec2.x + vec1.y * vec2.y + vec1.z * vec2.z;
-    float magnitude1 = std::sqrt(vec1.x * vec1.x + vec1.y * vec1.y + vec1.z * vec1.z);
-    float magnitude2 = std::sqrt(vec2.x * vec2.x + vec2.y * vec2.y + vec2.z * vec2.z);
-    
-    float cos_angle = dot_product / (magnitude1 * magnitude2);
-    cos_angle = std::max(-1.0f, std::min(1.0f, cos_angle));  // Clamp to [-1, 1] to avoid domain errors
-    
-    return std::acos(cos_angle) * (180.0f / M_PI);  // Convert to degrees
+
+    if (writesCsv(options.logFormat)) {
+        report["csvWriter"] = writerStatsJson(session.logFile.stats());
+    }
+    if (writesBinary(options.logFormat)) {
+        report["binaryLogWriter"] = writerStatsJson(session.binaryLog.stats());
+    }
+
+    LeapPoolAllocator::Stats allocatorStats = leapAllocator.stats();
+    report["allocator"] = {
+        {"liveBytes", allocatorStats.liveBytes},
+        {"peakBytes", allocatorStats.peakBytes},
+        {"reservedBytes", allocatorStats.reservedBytes},
+        {"allocations", allocatorStats.allocations},
+        {"poolHits", allocatorStats.poolHits}
+    };
+
+    for (int i = 0; i < PolicyManager::StreamCount; i++) {
+        PolicyManager::Stream stream = static_cast<PolicyManager::Stream>(i);
+        if (!PolicyManager::isMetered(stream)) {
+            continue;
+        }
+        report["streamBytesPerSecond"][PolicyManager::streamName(stream)] = policyManager.bytesPerSecond(stream);
+    }
+
+    return report.dump();
 }
 
-float LeapTracker::calculatePronationSupinationMetric(const LEAP_HAND* hand) {
-    // Use palm normal to determine pronation/supination
-    float angle = std::atan2(hand->palm.normal.y, hand->palm.normal.x);
-    // Normalise angle to 0-1 range, where 0 is full pronation and 1 is full supination
-    return static_cast<float>((angle + M_PI/2) / M_PI);
+nlohmann::json LeapTracker::statisticsReport(TrackingSession& session) {
+    nlohmann::json report = session.statistics->toJson();
+    report["clientName"] = session.spec.clientName;
+    report["sessionNumber"] = session.spec.sessionNumber;
+    report["exerciseName"] = session.spec.exerciseName;
+    return report;
 }
 
-float LeapTracker::calculateWristAROMMetric(const LEAP_HAND* hand) {
-    // Calculate wrist angle relative to forearm
-    LEAP_VECTOR wristDirection = {
-        hand->arm.next_joint.x - hand->arm.prev_joint.x,
-        hand->arm.next_joint.y - hand->arm.prev_joint.y,
-        hand->arm.next_joint.z - hand->arm.prev_joint.z
-    };
-    LEAP_VECTOR palmDirection = hand->palm.direction;
-    
-    // Normalise vectors
-    float wristMagnitude = std::sqrt(wristDirection.x * wristDirection.x + wristDirection.y * wristDirection.y + wristDirection.z * wristDirection.z);
-    float palmMagnitude = std::sqrt(palmDirection.x * palmDirection.x + palmDirection.y * palmDirection.y + palmDirection.z * palmDirection.z);
-    
-    LEAP_VECTOR normalisedWristDirection = {
-        wristDirection.x / wristMagnitude,
-        wristDirection.y / wristMagnitude,
-        wristDirection.z / wristMagnitude
-    };
-    
-    LEAP_VECTOR normalisedPalmDirection = {
-        palmDirection.x / palmMagnitude,
-        palmDirection.y / palmMagnitude,
-        palmDirection.z / palmMagnitude
-    };
-    
-    float dotProduct = normalisedWristDirection.x * normalisedPalmDirection.x + 
-                       normalisedWristDirection.y * normalisedPalmDirection.y + 
-                       normalisedWristDirection.z * normalisedPalmDirection.z;
-    
-    float angle = std::acos(std::max(-1.0f, std::min(1.0f, dotProduct)));
-    
-    // Map angle to 0-1 range, where 0.5 is neutral, 1 is max upward bend, and 0 is max downward bend
-    const float maxAngle = static_cast<float>(M_PI / 2); // 90 degrees
-    float normalisedAngle = angle / maxAngle;
-    
-    // Determine if the bend is upward or downward
-    float upDownFactor = normalisedPalmDirection.y > 0 ? 1.0f : -1.0f;
-    
-    // Map the range [-1, 1] to [0, 1]
-    return std::max(0.0f, std::min(1.0f, (normalisedAngle * upDownFactor + 1.0f) / 2.0f));
+std::string LeapTracker::getStatisticsJson(size_t index) {
+    return statisticsReport(*sessions.at(index)).dump();
+}
+
+// <log file>.csv -> <log file>_summary.json
+void LeapTracker::writeSessionSummary(TrackingSession& session) {
+    std::string path = session.logFilePath;
+    size_t extension = path.rfind(".csv");
+    if (extension != std::string::npos) {
+        path.erase(extension);
+    }
+    path += "_summary.json";
+
+    std::ofstream summaryFile(path, std::ofstream::out);
+    if (!summaryFile.is_open()) {
+        std::cerr << "Failed to open session summary at: " << path << std::endl;
+        return;
+    }
+    summaryFile << statisticsReport(session).dump(2) << "\n";
+    std::cout << "Session summary written to: " << path << std::endl;
+}
+
+void LeapTracker::saveCalibration(TrackingSession& session) {
+    if (session.calibrationRecorder->apply(session.calibration) == 0) {
+        std::cout << "No metric ranges recorded; calibration file left unchanged" << std::endl;
+        return;
+    }
+    if (session.calibration.save(session.calibrationPath)) {
+        std::cout << "Calibration saved to: " << session.calibrationPath << std::endl;
+    }
+}
+
+void LeapTracker::broadcastWebSocketMessage(TrackingSession& session, const std::string& message, uint32_t output) {
+    std::lock_guard<std::mutex> lock(session.wsMutex);
+    for (auto& hdl : session.wsConnections) {
+        auto outputs = session.wsOutputs.find(hdl);
+        uint32_t mask = outputs == session.wsOutputs.end() ? TrackingSession::FrameOutput : outputs->second;
+        if (!(mask & output)) {
+            continue;
+        }
+        try {
+            sessionManager->server().send(hdl, message, websocketpp::frame::opcode::text);
+        } catch (const websocketpp::exception& e) {
+            std::cerr << "Error sending WebSocket message: " << e.what() << std::endl;
+        }
+    }
 }
 
 // Start tracking
 void LeapTracker::startTracking() {
     isTracking = true;
+    for (auto& session : sessions) {
+        session->processingThread = std::thread(&LeapTracker::processFrames, this, std::ref(*session));
+    }
     pollingThread = std::thread(&LeapTracker::pollConnection, this);
+
+    if (options.dashboard && !options.verboseRows) {
+        std::vector<ConsoleDashboard::Source> sources;
+        for (auto& session : sessions) {
+            sources.push_back({
+                "Session " + std::to_string(session->index) + " (" + session->spec.clientName + ", " + session->spec.exerciseName + ")",
+                &session->dashboardFeed,
+                &session->metrics,
+                session->frameRing.get(),
+                session->exercisePipeline,
+                writesCsv(options.logFormat) ? &session->logFile : nullptr,
+                writesBinary(options.logFormat) ? &session->binaryLog : nullptr
+            });
+        }
+        dashboard = std::make_unique<ConsoleDashboard>(options.dashboardInterval);
+        dashboard->start(sources);
+    }
 }
 
 // Stop tracking
 void LeapTracker::stopTracking() {
     isTracking = false;
+    for (auto& session : sessions) {
+        session->frameRing->close();
+    }
     if (pollingThread.joinable()) {
         pollingThread.join();
     }
+    std::vector<TrackingSession*> stopped;
+    for (auto& session : sessions) {
+        if (session->processingThread.joinable()) {
+            session->processingThread.join();
+            stopped.push_back(session.get());
+        }
+    }
+    // Its last refresh shows the drained state, above the summaries
+    if (dashboard) {
+        dashboard->stop();
+        dashboard.reset();
+    }
+    for (TrackingSession* session : stopped) {
+        if (sessions.size() > 1) {
+            std::cout << "Session " << session->index << " (" << (session->bound ? session->serial : "no device") << "):" << std::endl;
+        }
+        FrameRing& frameRing = *session->frameRing;
+        std::cout << "Frame ring: " << frameRing.pushedCount() << " frames queued, "
+                  << frameRing.overflowCount() << " overflows (" << FrameRing::policyName(frameRing.policy()) << ")" << std::endl;
+        std::cout << session->metrics.summary();
+
+        // Everything the processing thread appended is written before the summary files
+        session->logFile.close();
+        session->binaryLog.close();
+        if (writesCsv(options.logFormat)) {
+            printWriterStats("CSV writer", session->logFile.stats());
+        }
+        if (writesBinary(options.logFormat)) {
+            printWriterStats("Binary log writer", session->binaryLog.stats());
+        }
+        writeSessionSummary(*session);
+        if (session->calibrationRecorder) {
+            saveCalibration(*session);
+        }
+    }
 }
 
 std::string LeapTracker::getLatestData() {
@@ -302,235 +594,532 @@ std::string LeapTracker::getLatestData() {
 
 void LeapTracker::pollConnection() {
     LEAP_CONNECTION_MESSAGE msg;
-    eLeapRS result = LeapCreateConnection(nullptr, &connection);
+    // Multi-device aware: tracking only arrives from devices we subscribe to, tagged with their id
+    LEAP_CONNECTION_CONFIG config;
+    memset(&config, 0, sizeof(config));
+    config.size = sizeof(config);
+    config.flags = eLeapConnectionConfig_MultiDeviceAware;
+    eLeapRS result = LeapCreateConnection(&config, &connection);
     if (result != eLeapRS_Success) {
         std::cerr << "Failed to create connection: " << result << std::endl;
         return;
     }
 
+    // Route LeapC's event buffers through our pool so they are recycled between frames
+    result = LeapSetAllocator(connection, leapAllocator.leapAllocator());
+    if (result != eLeapRS_Success) {
+        std::cerr << "Failed to set LeapC allocator: " << result << std::endl;
+    }
+
     result = LeapOpenConnection(connection);
     if (result != eLeapRS_Success) {
         std::cerr << "Failed to open connection: " << result << std::endl;
+        LeapDestroyConnection(connection);
         return;
     }
 
-    bool policySet = false;
     while (isTracking) {
         result = LeapPollConnection(connection, 1000, &msg);
         if (result == eLeapRS_Success) {
+            policyManager.recordEvent(msg);
             switch (msg.type) {
                 case eLeapEventType_Connection:
                     std::cout << "Connected to Leap Service" << std::endl;
-                    if (!policySet) {
-                        result = LeapSetPolicyFlags(connection, eLeapPolicyFlag_Images | eLeapPolicyFlag_MapPoints, 0);
-                        if (result == eLeapRS_Success) {
-                            std::cout << "Successfully set policy flags" << std::endl;
-                            policySet = true;
-                        } else {
-                            std::cerr << "Failed to set policy flags: " << result << std::endl;
-                        }
+                    policyManager.onConnected(connection);
+                    attachDevices();
+                    break;
+                case eLeapEventType_ConnectionLost:
+                    std::cerr << "Lost connection to Leap Service" << std::endl;
+                    policyManager.onConnectionLost();
+                    break;
+                case eLeapEventType_Device:
+                    attachDevice(msg.device_event->device);
+                    break;
+                case eLeapEventType_DeviceLost:
+                    if (TrackingSession* session = sessionForDevice(msg.device_event->device.id)) {
+                        std::cerr << "Lost device " << session->serial << " (session " << session->index << ")" << std::endl;
+                        detachDevice(*session);
+                    }
+                    break;
+                case eLeapEventType_Policy:
+                    policyManager.onPolicyEvent(msg.policy_event);
+                    break;
+                case eLeapEventType_DroppedFrame:
+                    if (TrackingSession* session = sessionForDevice(msg.device_id)) {
+                        session->metrics.recordDroppedFrame(msg.dropped_frame_event->type);
                     }
                     break;
                 case eLeapEventType_Tracking:
-                    processFrame(msg.tracking_event);
+                    // Only copy the frame here; output runs on the device's processing thread.
+                    // With a fixed output rate the resampler feeds the ring instead.
+                    if (TrackingSession* session = sessionForDevice(msg.device_id)) {
+                        if (!session->frameResampler) {
+                            session->frameRing->push(msg.tracking_event, LeapGetNow());
+                        }
+                    }
                     break;
                 default:
                     break;
             }
         }
+        // Push subscription changes made by WebSocket clients since the last poll
+        policyManager.apply(connection);
     }
 
+    // Resamplers interpolate on this connection, so they stop before it closes
+    for (auto& session : sessions) {
+        session->resampling = false;
+        if (session->resamplingThread.joinable()) {
+            session->resamplingThread.join();
+            FrameResampler& resampler = *session->frameResampler;
+            std::cout << "Resampler " << session->index << ": " << resampler.samplesProduced() << " frames at " << resampler.rate() << " Hz, "
+                      << resampler.samplesMissed() << " missed, " << resampler.ticksSkipped() << " ticks skipped" << std::endl;
+        }
+        if (session->device) {
+            LeapCloseDevice(session->device);
+            session->device = nullptr;
+        }
+    }
+    sessionsByDevice.clear();
+
+    std::cout << policyManager.report() << std::endl;
     LeapCloseConnection(connection);
     LeapDestroyConnection(connection);
+    std::cout << leapAllocator.describe() << std::endl;
+}
+
+// Binds devices already attached when the connection comes up; later ones arrive as device events
+void LeapTracker::attachDevices() {
+    uint32_t deviceCount = 0;
+    if (LeapGetDeviceList(connection, nullptr, &deviceCount) != eLeapRS_Success || deviceCount == 0) {
+        return;
+    }
+    std::vector<LEAP_DEVICE_REF> refs(deviceCount);
+    if (LeapGetDeviceList(connection, refs.data(), &deviceCount) != eLeapRS_Success) {
+        return;
+    }
+    for (uint32_t i = 0; i < deviceCount; i++) {
+        attachDevice(refs[i]);
+    }
+}
+
+// Gives a newly seen controller the next free session and subscribes to its events
+void LeapTracker::attachDevice(const LEAP_DEVICE_REF& ref) {
+    if (sessionsByDevice.count(ref.id)) {
+        return;
+    }
+
+    LEAP_DEVICE device;
+    eLeapRS result = LeapOpenDevice(ref, &device);
+    if (result != eLeapRS_Success) {
+        std::cerr << "Failed to open device " << ref.id << ": " << result << std::endl;
+        return;
+    }
+
+    // The first call reports the serial length, the second fills it in
+    LEAP_DEVICE_INFO info;
+    memset(&info, 0, sizeof(info));
+    info.size = sizeof(info);
+    std::string serial;
+    if (LeapGetDeviceInfo(device, &info) == eLeapRS_InsufficientBuffer && info.serial_length > 0) {
+        std::vector<char> buffer(info.serial_length);
+        info.serial = buffer.data();
+        if (LeapGetDeviceInfo(device, &info) == eLeapRS_Success) {
+            serial = buffer.data();
+        }
+    }
+    if (serial.empty()) {
+        serial = "device" + std::to_string(ref.id);
+    }
+
+    TrackingSession* target = unboundSessionFor(serial);
+    if (!target) {
+        std::cerr << "Ignoring device " << serial << ": no session is waiting for it (see --devices and --session)" << std::endl;
+        LeapCloseDevice(device);
+        return;
+    }
+
+    result = LeapSubscribeEvents(connection, device);
+    if (result != eLeapRS_Success) {
+        std::cerr << "Failed to subscribe to device " << serial << ": " << result << std::endl;
+        LeapCloseDevice(device);
+        return;
+    }
+
+    TrackingSession& session = *target;
+    session.device = device;
+    session.serial = serial;
+    session.deviceId = ref.id;
+    session.bound = true;
+    sessionsByDevice[ref.id] = &session;
+    std::cout << "Device " << serial << " -> session " << session.index << " (" << session.spec.clientName << ")" << std::endl;
+
+    if (session.frameResampler) {
+        session.resampling = true;
+        session.resamplingThread = std::thread(&FrameResampler::run, session.frameResampler.get(), connection, device,
+                                                std::cref(session.resampling), std::ref(*session.frameRing));
+    }
+}
+
+// Frees a session whose controller was unplugged, so the controller (under a
+// new LeapC id) or another one can be attached to it again
+void LeapTracker::detachDevice(TrackingSession& session) {
+    session.bound = false;
+    // The resampler interpolates from this device, so it stops before the device closes
+    session.resampling = false;
+    if (session.resamplingThread.joinable()) {
+        session.resamplingThread.join();
+    }
+    sessionsByDevice.erase(session.deviceId);
+    if (session.device) {
+        LeapCloseDevice(session.device);
+        session.device = nullptr;
+    }
+}
+
+// The session this controller was last bound to wins, then a session asking
+// for its serial, then the first session that named no device
+TrackingSession* LeapTracker::unboundSessionFor(const std::string& serial) {
+    for (auto& session : sessions) {
+        if (!session->device && session->serial == serial) {
+            return session.get();
+        }
+    }
+    for (auto& session : sessions) {
+        if (!session->device && session->spec.deviceSerial == serial) {
+            return session.get();
+        }
+    }
+    for (auto& session : sessions) {
+        if (!session->device && session->spec.deviceSerial.empty()) {
+            return session.get();
+        }
+    }
+    return nullptr;
+}
+
+TrackingSession* LeapTracker::sessionForDevice(uint32_t deviceId) {
+    auto it = sessionsByDevice.find(deviceId);
+    return it == sessionsByDevice.end() ? nullptr : it->second;
 }
 
-void LeapTracker::processFrame(const LEAP_TRACKING_EVENT* frame) {
+void LeapTracker::processFrames(TrackingSession& session) {
+    FrameSnapshot snapshot;
+    TrackerMetrics& metrics = session.metrics;
+    FrameRecorder& frameRecorder = session.frameRecorder;
+    // Sleeps while the ring is empty; stopTracking closes it, and frames already queued still reach the log
+    while (session.frameRing->waitPop(snapshot)) {
+        int64_t dequeuedAt = LeapGetNow();
+        metrics.record(TrackerMetrics::CaptureToPoll, std::max<int64_t>(0, snapshot.polledAt - snapshot.info.timestamp) * 1000);
+        metrics.record(TrackerMetrics::Queue, std::max<int64_t>(0, dequeuedAt - snapshot.polledAt) * 1000);
+
+        LEAP_TRACKING_EVENT frame = snapshot.view();
+        frameRecorder.write(&frame);
+        processFrame(session, &frame);
+
+        metrics.record(TrackerMetrics::EndToEnd, std::max<int64_t>(0, LeapGetNow() - snapshot.info.timestamp) * 1000);
+        metrics.countFrame();
+    }
+
+    if (frameRecorder.isOpen()) {
+        std::cout << "Recorded " << frameRecorder.framesWritten() << " frames" << std::endl;
+        frameRecorder.close();
+    }
+}
+
+void LeapTracker::processFrame(TrackingSession& session, const LEAP_TRACKING_EVENT* frame) {
+    StageTimer timer(session.metrics);
+
     // Send hand presence OSC message before processing individual hands
     bool handPresent = frame->nHands > 0;
-    sendHandPresenceOsc(handPresent);
+    sendHandPresenceOsc(session, handPresent);
+    uint32_t present = 0;
+    for (uint32_t h = 0; h < frame->nHands; h++) {
+        present |= 1u << handSlot(frame->pHands[h].type);
+    }
+    session.dashboardFeed.publishHands(present);
+    if (options.bimanual) {
+        for (int slot = 0; slot < kHandSlots; slot++) {
+            sendOscMessage(session, HandOscAddresses::forSlot(slot).handPresence.c_str(), present & (1u << slot) ? 1.0f : 0.0f);
+        }
+    }
+    timer.lap(TrackerMetrics::Send);
+
+    // Stamp the frame once from its device capture time; every hand row shares it
+    char timestamp[DEVICE_CLOCK_TIMESTAMP_SIZE];
+    int64_t epochMicros = session.deviceClock.toEpochMicros(frame->info.timestamp);
+    size_t timestampLength = session.deviceClock.format(epochMicros, options.timestampFormat, timestamp);
 
     nlohmann::json frameData;
-    frameData["timestamp"] = getCurrentTimestamp();
+    if (options.timestampFormat == DeviceClock::Format::EpochMicros) {
+        frameData["timestamp"] = epochMicros;
+    } else {
+        frameData["timestamp"] = std::string(timestamp, timestampLength);
+    }
     frameData["handPresent"] = handPresent;
+    if (options.bimanual) {
+        frameData["hands"] = nlohmann::json::array();
+    }
+    timer.lap(TrackerMetrics::Serialize);
+
+    static const char* fingerNames[5] = {"thumb", "index", "middle", "ring", "pinky"};
+    const ExercisePipeline& pipeline = *session.exercisePipeline;
+    bool quaternionAngles = options.jointAngleSource == JointAngleSource::Quaternion;
 
     for (uint32_t h = 0; h < frame->nHands; h++) {
         const LEAP_HAND* hand = &frame->pHands[h];
-        LEAP_VECTOR thumbPos = hand->thumb.distal.next_joint;
-        LEAP_VECTOR indexPos = hand->index.distal.next_joint;
-        LEAP_VECTOR middlePos = hand->middle.distal.next_joint;
-        LEAP_VECTOR ringPos = hand->ring.distal.next_joint;
-        LEAP_VECTOR pinkyPos = hand->pinky.distal.next_joint;
-
-        thumbIndexDistance = calculateDistance(thumbPos, indexPos);
-        thumbMiddleDistance = calculateDistance(thumbPos, middlePos);
-        thumbRingDistance = calculateDistance(thumbPos, ringPos);
-        thumbPinkyDistance = calculateDistance(thumbPos, pinkyPos);
-
-        std::stringstream ss;
-        ss << clientName << "," << sessionNumber << "," << exerciseName << "," << getCurrentTimestamp() << "," << hand->type << ",";
-
-        // Collect finger data
-        LEAP_DIGIT fingers[5] = { hand->thumb, hand->index, hand->middle, hand->ring, hand->pinky };
-        std::string fingerNames[5] = {"thumb", "index", "middle", "ring", "pinky"};
-        for (int i = 0; i < 5; i++) {
-            const auto& finger = fingers[i];
-            LEAP_VECTOR tip = finger.distal.next_joint;
-            ss << tip.x << "," << tip.y << "," << tip.z << ",";
-            
-            frameData["fingers"][fingerNames[i]] = {
-                {"x", tip.x},
-                {"y", tip.y},
-                {"z", tip.z}
-            };
+
+        // Bone directions, joint angles and distances, computed once for every consumer below
+        HandGeometry geometry;
+        computeHandGeometry(*hand, geometry);
+
+        // Signed angles from bone rotations, which also give abduction
+        HandKinematics kinematics;
+        if (quaternionAngles) {
+            computeHandKinematics(*hand, kinematics);
         }
 
-        // Calculate and collect joint angles
+        // Gather every output value of the hand into one channel array
+        HandChannels raw;
         for (int i = 0; i < 5; i++) {
-            const auto& finger = fingers[i];
-            float mcp = calculateAngle(finger.metacarpal.prev_joint, finger.metacarpal.next_joint, finger.proximal.next_joint);
-            float pip = calculateAngle(finger.metacarpal.next_joint, finger.proximal.next_joint, finger.intermediate.next_joint);
-            float dip = calculateAngle(finger.proximal.next_joint, finger.intermediate.next_joint, finger.distal.next_joint);
-            ss << mcp << "," << pip << "," << dip << ",";
-            
-            frameData["joints"][fingerNames[i]] = {
-                {"mcp", mcp},
-                {"pip", pip},
-                {"dip", dip}
-            };
+            const LEAP_VECTOR& tip = hand->digits[i].distal.next_joint;
+            const float* angles = quaternionAngles ? kinematics.flexion[i] : geometry.jointAngles[i];
+            for (int a = 0; a < 3; a++) {
+                raw[HandChannels::Tips + 3 * i + a] = tip.v[a];
+                raw[HandChannels::Joints + 3 * i + a] = angles[a];
+            }
+            raw[HandChannels::Abduction + i] = quaternionAngles ? kinematics.abduction[i][0] : 0.0f;
         }
 
-        // Collect wrist and palm data
+        // Calculate wrist and palm data
         LEAP_VECTOR wristPos = hand->palm.position;
         LEAP_VECTOR palmPos = hand->palm.position;
-        float palmRoll = computeRoll(hand->palm.normal);
-        float palmPitch = computePitch(hand->palm.direction);
-        float palmYaw = computeYaw(hand->palm.direction);
-        float handRoll = palmRoll;
-        float handPitch = palmPitch;
-        float handYaw = palmYaw;
-        float wristFlexionExtension = computeWristFlexionExtension(wristPos, palmPos);
-        float wristRadialUlnarDeviation = computeWristRadialUlnarDeviation(wristPos, palmPos);
-
-        ss  << wristPos.x << "," << wristPos.y << "," << wristPos.z << ","
-            << wristFlexionExtension << "," << "0" << "," 
-            << wristRadialUlnarDeviation << "," << "0" << ","
-            << palmPos.x << "," << palmPos.y << "," << palmPos.z << ","
-            << palmRoll << "," << palmPitch << "," << palmYaw << ","
-            << handRoll << "," << handPitch << "," << handYaw << ","
-            << thumbIndexDistance << "," << thumbMiddleDistance << ","
-            << thumbRingDistance << "," << thumbPinkyDistance << "\n";
-
-        frameData["wrist"] = {
-            {"x", wristPos.x},
-            {"y", wristPos.y},
-            {"z", wristPos.z},
-            {"flexionExtension", wristFlexionExtension},
-            {"radialUlnarDeviation", wristRadialUlnarDeviation}
+        for (int a = 0; a < 3; a++) {
+            raw[HandChannels::Wrist + a] = wristPos.v[a];
+            raw[HandChannels::Palm + a] = palmPos.v[a];
+        }
+        if (quaternionAngles) {
+            raw[HandChannels::WristAngles + 0] = std::max(0.0f, kinematics.wristFlexion);
+            raw[HandChannels::WristAngles + 1] = std::max(0.0f, -kinematics.wristFlexion);
+            raw[HandChannels::WristAngles + 2] = std::max(0.0f, -kinematics.wristDeviation);
+            raw[HandChannels::WristAngles + 3] = std::max(0.0f, kinematics.wristDeviation);
+        } else {
+            // The position method cannot tell extension from flexion or ulnar from radial deviation
+            raw[HandChannels::WristAngles + 0] = computeWristFlexionExtension(wristPos, palmPos);
+            raw[HandChannels::WristAngles + 1] = 0.0f;
+            raw[HandChannels::WristAngles + 2] = computeWristRadialUlnarDeviation(wristPos, palmPos);
+            raw[HandChannels::WristAngles + 3] = 0.0f;
+        }
+        raw[HandChannels::PalmAngles + 0] = computeRoll(hand->palm.normal);
+        raw[HandChannels::PalmAngles + 1] = computePitch(hand->palm.direction);
+        raw[HandChannels::PalmAngles + 2] = computeYaw(hand->palm.direction);
+        for (int i = 0; i < 4; i++) {
+            raw[HandChannels::ThumbDistances + i] = geometry.thumbDistances[i];
+        }
+
+        // Calculate only the metrics this session's exercise reports
+        const MetricCalibration& calibration = session.calibration.forHand(hand->type);
+        if (session.calibrationRecorder) {
+            // Record the raw quantities, then scale them as the pipeline would have
+            float rawMetrics[kMetricCount];
+            pipeline.compute(geometry, MetricCalibration::identity(), rawMetrics);
+            session.calibrationRecorder->record(hand->type, rawMetrics);
+            for (size_t m = 0; m < pipeline.metricCount; m++) {
+                raw[HandChannels::Metrics + static_cast<int>(m)] = calibration[pipeline.metrics[m]].apply(rawMetrics[m]);
+            }
+        } else {
+            pipeline.compute(geometry, calibration, &raw[HandChannels::Metrics]);
+        }
+        for (int c = HandChannels::Metrics + static_cast<int>(pipeline.metricCount); c < HandChannels::Abduction; c++) {
+            raw[c] = 0.0f;
+        }
+        for (int c = HandChannels::Count; c < HandChannels::kCapacity; c++) {
+            raw[c] = 0.0f;
+        }
+        session.statistics->update(hand->type, raw);
+        session.eventDetector->update(hand->type, frame->info.timestamp, raw, session.events);
+        timer.lap(TrackerMetrics::Compute);
+
+        // Smooth what the game sees; the CSV keeps the unfiltered values
+        HandChannels live = raw;
+        HandStateTable::Entry& handState = session.hands->lookup(*hand);
+        handState.filter->apply(frame->info.timestamp, live.values);
+        timer.lap(TrackerMetrics::Filter);
+
+        if (writesCsv(options.logFormat)) {
+            RowFormatter& row = *session.csvRow;
+            row.begin();
+            row.append(timestamp, timestampLength);
+            row.appendField(static_cast<int64_t>(hand->type));
+            for (int channel : session.columns->channels) {
+                row.appendField(raw[channel]);
+            }
+            row.end();
+        }
+
+        // Bimanual mode gives each hand its own entry in "hands"; otherwise
+        // the hand's keys sit at the top level of the frame
+        nlohmann::json* handOutput = &frameData;
+        if (options.bimanual) {
+            frameData["hands"].push_back({
+                {"id", hand->id},
+                {"type", handTypeName(hand->type)}
+            });
+            handOutput = &frameData["hands"].back();
+        }
+        nlohmann::json& handData = *handOutput;
+
+        for (int i = 0; i < 5; i++) {
+            int tip = HandChannels::Tips + 3 * i;
+            handData["fingers"][fingerNames[i]] = {
+                {"x", live[tip]},
+                {"y", live[tip + 1]},
+                {"z", live[tip + 2]}
+            };
+
+            int joint = HandChannels::Joints + 3 * i;
+            handData["joints"][fingerNames[i]] = {
+                {"mcp", live[joint]},
+                {"pip", live[joint + 1]},
+                {"dip", live[joint + 2]}
+            };
+            if (quaternionAngles) {
+                handData["joints"][fingerNames[i]]["mcpAbduction"] = live[HandChannels::Abduction + i];
+            }
+        }
+
+        // Signed wrist angles when bone rotations give them
+        float flexionExtension = live[HandChannels::WristAngles + 0];
+        float radialUlnarDeviation = live[HandChannels::WristAngles + 2];
+        if (quaternionAngles) {
+            flexionExtension -= live[HandChannels::WristAngles + 1];
+            radialUlnarDeviation = live[HandChannels::WristAngles + 3] - radialUlnarDeviation;
+        }
+        handData["wrist"] = {
+            {"x", live[HandChannels::Wrist]},
+            {"y", live[HandChannels::Wrist + 1]},
+            {"z", live[HandChannels::Wrist + 2]},
+            {"flexionExtension", flexionExtension},
+            {"radialUlnarDeviation", radialUlnarDeviation}
         };
 
-        frameData["palm"] = {
-            {"x", palmPos.x},
-            {"y", palmPos.y},
-            {"z", palmPos.z},
-            {"roll", palmRoll},
-            {"pitch", palmPitch},
-            {"yaw", palmYaw}
+        handData["palm"] = {
+            {"x", live[HandChannels::Palm]},
+            {"y", live[HandChannels::Palm + 1]},
+            {"z", live[HandChannels::Palm + 2]},
+            {"roll", live[HandChannels::PalmAngles]},
+            {"pitch", live[HandChannels::PalmAngles + 1]},
+            {"yaw", live[HandChannels::PalmAngles + 2]}
         };
 
-        frameData["hand"] = {
-            {"roll", handRoll},
-            {"pitch", handPitch},
-            {"yaw", handYaw}
+        handData["hand"] = {
+            {"roll", live[HandChannels::PalmAngles]},
+            {"pitch", live[HandChannels::PalmAngles + 1]},
+            {"yaw", live[HandChannels::PalmAngles + 2]}
         };
 
-        frameData["distances"] = {
-            {"thumbIndex", thumbIndexDistance},
-            {"thumbMiddle", thumbMiddleDistance},
-            {"thumbRing", thumbRingDistance},
-            {"thumbPinky", thumbPinkyDistance}
+        handData["distances"] = {
+            {"thumbIndex", live[HandChannels::ThumbDistances]},
+            {"thumbMiddle", live[HandChannels::ThumbDistances + 1]},
+            {"thumbRing", live[HandChannels::ThumbDistances + 2]},
+            {"thumbPinky", live[HandChannels::ThumbDistances + 3]}
         };
 
-        std::string logEntry = ss.str();
-        logFile << logEntry;
-        std::cout << logEntry;  // Stream to terminal
+        nlohmann::json metrics = nlohmann::json::object();
+        for (size_t m = 0; m < pipeline.metricCount; m++) {
+            metrics[metricInfo(pipeline.metrics[m]).jsonKey] = live[HandChannels::Metrics + static_cast<int>(m)];
+        }
+        handData["metrics"] = metrics;
+        session.dashboardFeed.publishMetrics(handSlot(hand->type), &live[HandChannels::Metrics], pipeline.metricCount);
 
-        // Calculate and send exercise metrics
-        float makeAFistMetric = calculateMakeAFistMetric(hand);
-        float pronationSupinationMetric = calculatePronationSupinationMetric(hand);
-        float wristAROMMetric = calculateWristAROMMetric(hand);
+        timer.lap(TrackerMetrics::Serialize);
 
-        frameData["metrics"] = {
-            {"makeAFist", makeAFistMetric},
-            {"pronationSupination", pronationSupinationMetric},
-            {"wristAROM", wristAROMMetric}
-        };
+        if (writesCsv(options.logFormat)) {
+            session.logFile.append(session.csvRow->data(), session.csvRow->size());
+            if (options.verboseRows) {
+                std::cout.write(session.csvRow->data(), session.csvRow->size());
+            }
+        }
+        if (writesBinary(options.logFormat)) {
+            session.binaryLog.append(frame->info.timestamp, epochMicros, *hand, raw);
+        }
 
         // Send individual OSC messages
-        sendOscMessage("/leap/thumb_x", thumbPos.x);
-        sendOscMessage("/leap/thumb_y", thumbPos.y);
-        sendOscMessage("/leap/thumb_z", thumbPos.z);
-        sendOscMessage("/leap/index_x", indexPos.x);
-        sendOscMessage("/leap/index_y", indexPos.y);
-        sendOscMessage("/leap/index_z", indexPos.z);
-        sendOscMessage("/leap/middle_x", middlePos.x);
-        sendOscMessage("/leap/middle_y", middlePos.y);
-        sendOscMessage("/leap/middle_z", middlePos.z);
-        sendOscMessage("/leap/ring_x", ringPos.x);
-        sendOscMessage("/leap/ring_y", ringPos.y);
-        sendOscMessage("/leap/ring_z", ringPos.z);
-        sendOscMessage("/leap/pinky_x", pinkyPos.x);
-        sendOscMessage("/leap/pinky_y", pinkyPos.y);
-        sendOscMessage("/leap/pinky_z", pinkyPos.z);
-        sendOscMessage("/leap/thumb_index_distance", thumbIndexDistance);
-        sendOscMessage("/leap/thumb_middle_distance", thumbMiddleDistance);
-        sendOscMessage("/leap/thumb_ring_distance", thumbRingDistance);
-        sendOscMessage("/leap/thumb_pinky_distance", thumbPinkyDistance);
-        sendOscMessage("/leap/make_a_fist", makeAFistMetric);
-        sendOscMessage("/leap/pronation_supination", pronationSupinationMetric);
-        sendOscMessage("/leap/wrist_arom", wristAROMMetric);
-    }
-
-    broadcastWebSocketMessage(frameData.dump());
-}
-
-
-float LeapTracker::calculateDistance(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2) {
-    float dx = p1.x - p2.x;
-    float dy = p1.y - p2.y;
-    float dz = p1.z - p2.z;
-    return std::sqrt(dx*dx + dy*dy + dz*dz);
-}
-
-float LeapTracker::calculateAngle(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2, const LEAP_VECTOR& p3) {
-    LEAP_VECTOR v1 = { p2.x - p1.x, p2.y - p1.y, p2.z - p1.z };
-    LEAP_VECTOR v2 = { p3.x - p2.x, p3.y - p2.y, p3.z - p2.z };
-    float dot = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
-    float mag1 = std::sqrt(v1.x * v1.x + v1.y * v1.y + v1.z * v1.z);
-    float mag2 = std::sqrt(v2.x * v2.x + v2.y * v2.y + v2.z * v2.z);
-    return std::acos(dot / (mag1 * mag2)) * 180.0 / M_PI;
-}
-
-std::string LeapTracker::getCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %X");
-    return ss.str();
+        const HandOscAddresses& addresses = HandOscAddresses::forSlot(options.bimanual ? handSlot(hand->type) : -1);
+        for (int i = 0; i < 5; i++) {
+            for (int a = 0; a < 3; a++) {
+                sendOscMessage(session, addresses.tips[i][a].c_str(), live[HandChannels::Tips + 3 * i + a]);
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            sendOscMessage(session, addresses.distances[i].c_str(), live[HandChannels::ThumbDistances + i]);
+        }
+        for (size_t m = 0; m < pipeline.metricCount; m++) {
+            sendOscMessage(session, addresses.metrics[static_cast<size_t>(pipeline.metrics[m])].c_str(),
+                           live[HandChannels::Metrics + static_cast<int>(m)]);
+        }
+        timer.lap(TrackerMetrics::Send);
+    }
+
+    std::string message = frameData.dump();
+    timer.lap(TrackerMetrics::Serialize);
+    broadcastWebSocketMessage(session, message);
+    if (!session.events.empty()) {
+        sendEvents(session, frame->info.timestamp, epochMicros);
+    }
+    timer.lap(TrackerMetrics::Send);
+    timer.finish();
 }
 
+
 bool LeapTracker::fileExists(const std::string& filePath) {
     struct stat buffer;
     return (stat(filePath.c_str(), &buffer) == 0);
 }
 
-void LeapTracker::sendOscMessage(const char* address, float value) {
+void LeapTracker::sendOscMessage(TrackingSession& session, const char* address, float value) {
     char buffer[OUTPUT_BUFFER_SIZE];
     tosc_writeMessage(buffer, sizeof(buffer), address, "f", value);
-    sendto(oscSocket, buffer, sizeof(buffer), 0, (struct sockaddr*)&oscAddr, sizeof(oscAddr));
+    sessionManager->sendOsc(session.oscAddr, buffer, sizeof(buffer));
+}
+
+// One OSC message per event, /leap/event/<rule>_<kind> with hand, value, epoch
+// microseconds and repetition number, and a JSON message to event subscribers
+void LeapTracker::sendEvents(TrackingSession& session, int64_t frameTimestamp, int64_t frameEpochMicros) {
+    for (const DetectedEvent& event : session.events) {
+        const char* hand = handTypeName(event.hand);
+        const char* kind = DetectedEvent::kindName(event.kind);
+        // Events are stamped between frames; carry the offset onto the frame's wall-clock time
+        int64_t epochMicros = frameEpochMicros + (event.timestamp - frameTimestamp);
+
+        char address[64];
+        snprintf(address, sizeof(address), "/leap/event/%s_%s", event.rule, kind);
+        char buffer[OUTPUT_BUFFER_SIZE];
+        uint32_t length = tosc_writeMessage(buffer, sizeof(buffer), address, "sfhi", hand, event.value,
+                                            static_cast<long long>(epochMicros), static_cast<int32_t>(event.repetition));
+        sessionManager->sendOsc(session.oscAddr, buffer, length);
+
+        nlohmann::json message = {
+            {"event", event.rule},
+            {"type", kind},
+            {"hand", hand},
+            {"value", event.value},
+            {"repetition", event.repetition}
+        };
+        if (options.timestampFormat == DeviceClock::Format::EpochMicros) {
+            message["timestamp"] = epochMicros;
+        } else {
+            char timestamp[DEVICE_CLOCK_TIMESTAMP_SIZE];
+            size_t timestampLength = session.deviceClock.format(epochMicros, options.timestampFormat, timestamp);
+            message["timestamp"] = std::string(timestamp, timestampLength);
+        }
+        broadcastWebSocketMessage(session, message.dump(), TrackingSession::EventOutput);
+    }
+    session.events.clear();
 }
 
-void LeapTracker::sendHandPresenceOsc(bool isPresent) {
-    sendOscMessage("/leap/hand_presence", isPresent ? 1.0f : 0.0f);
+void LeapTracker::sendHandPresenceOsc(TrackingSession& session, bool isPresent) {
+    sendOscMessage(session, "/leap/hand_presence", isPresent ? 1.0f : 0.0f);
 }
 
 // end of  LeapTracker.cpp//
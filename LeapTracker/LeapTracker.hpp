@@ -7,7 +7,32 @@
 #define LeapTracker_hpp
 
 #include "LeapC.h"
+#include "FrameRing.hpp"
+#include "FrameRecording.hpp"
+#include "AsyncFileWriter.hpp"
+#include "FrameResampler.hpp"
+#include "HandKernel.hpp"
+#include "ExerciseMetrics.hpp"
+#include "ChannelFilter.hpp"
+#include "HandChannels.hpp"
+#include "HandStateTable.hpp"
+#include "SessionColumns.hpp"
+#include "SessionFile.hpp"
+#include "RowFormatter.hpp"
+#include "SessionStatistics.hpp"
+#include "EventDetector.hpp"
+#include "CalibrationCache.hpp"
+#include "DeviceClock.hpp"
+#include "TrackerMetrics.hpp"
+#include "LeapPoolAllocator.hpp"
+#include "PolicyManager.hpp"
+#include "SessionManager.hpp"
+#include "ConsoleDashboard.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <thread>
 #include <fstream>
 #include <sys/socket.h>
@@ -16,64 +41,203 @@
 #include <set>
 #include <memory>
 
-#include <websocketpp/config/asio_no_tls.hpp>
-#include <websocketpp/server.hpp>
+// Who and what one tracking session records
+struct SessionSpec {
+    std::string clientName;
+    int sessionNumber = 1;
+    std::string exerciseName;
+    // Bind to the controller with this serial; empty takes the next unclaimed one
+    std::string deviceSerial;
+};
+
+// Optional settings passed on the command line after the positional arguments
+struct LeapTrackerOptions {
+    size_t frameRingCapacity = 64;
+    FrameRing::OverflowPolicy frameRingPolicy = FrameRing::OverflowPolicy::DropOldest;
+    // Optional LeapC streams held open for the whole session (e.g. for an external recorder)
+    std::vector<PolicyManager::Stream> sessionStreams;
+    // Raw frame dump for later replay through the LeapC stand-in
+    std::string frameRecordingPath;
+    DeviceClock::Format timestampFormat = DeviceClock::Format::LocalMicros;
+    // Resample output to a fixed rate in Hz with LeapInterpolateFrame; 0 forwards device frames as they arrive
+    double outputRate = 0;
+    // How far resampled frames trail LeapGetNow(), so the target lies between frames LeapC already has
+    int64_t outputDelayMicros = 20000;
+    // Controllers to capture from for the session given on the command line;
+    // each extra one gets its own session with "_device<k>" file names
+    int deviceCount = 1;
+    // Serial of the controller for the command-line session; empty takes the first one found
+    std::string deviceSerial;
+    // Further patient sessions hosted in the same process, each with its own controller
+    std::vector<SessionSpec> extraSessions;
+    // Threads serving the shared WebSocket listener
+    int ioThreadCount = 1;
+    // Joint positions (unsigned angles) or bone rotations (signed flexion plus abduction)
+    JointAngleSource jointAngleSource = JointAngleSource::Position;
+    // Smoothing of the WebSocket and OSC output; the CSV always keeps the raw values
+    ChannelFilter::Type filterType = ChannelFilter::Type::None;
+    // Each hand in its own WebSocket "hands" entry and /leap/left/..., /leap/right/... OSC addresses
+    bool bimanual = false;
+    // Record each patient's metric ranges and save them to the calibration cache at stop
+    bool calibrate = false;
+    // CSV, the binary session format (next to the CSV, as .ltsb) or both
+    SessionLogFormat logFormat = SessionLogFormat::Csv;
+    // How CSV values are printed; the default matches printing them to a stream
+    RowFormatter::FloatFormat csvFloatFormat;
+    // Batching and fsync policy of the session log writer threads
+    AsyncFileWriter::Options csvWriter;
+    // Where <clientName>.calibration files are kept
+    std::string calibrationDirectory = ".";
+    // Terminal status view refreshed every dashboardInterval, instead of silence
+    bool dashboard = false;
+    std::chrono::milliseconds dashboardInterval{250};
+    // Print every CSV row to stdout as it is logged; replaces the dashboard
+    bool verboseRows = false;
+};
+
+// One patient session: the controller it is bound to and everything that
+// controller's frames flow through, i.e. its own frame ring, processing
+// thread, CSV file, OSC destination and WebSocket clients. Transport is shared
+// through the SessionManager; session k is reached at /session/<k> and sends
+// OSC to the base port plus k.
+struct TrackingSession {
+    int index;
+    SessionSpec spec;
+    // "_device<k>" for sessions added by --devices, which share the command-line spec
+    std::string fileSuffix;
+    int oscPort;
+    // Metrics this session's exercise reports, chosen from spec.exerciseName
+    const ExercisePipeline* exercisePipeline = nullptr;
+    // The patient's metric ranges, loaded from calibrationPath at startup
+    PatientCalibration calibration;
+    std::string calibrationPath;
+    // Set in calibration sessions; processing thread only until stop
+    std::unique_ptr<CalibrationRecorder> calibrationRecorder;
+
+    // Set by the polling thread when a controller is assigned and cleared
+    // when it is lost; other threads only read deviceId and serial after
+    // bound is set. serial is kept after a loss so the same controller
+    // comes back to this session when it is plugged in again.
+    LEAP_DEVICE device = nullptr;
+    uint32_t deviceId = 0;
+    std::string serial;
+    std::atomic<bool> bound{false};
+
+    std::unique_ptr<FrameRing> frameRing;
+    // Set when outputRate is given; it then becomes the ring's only producer
+    std::unique_ptr<FrameResampler> frameResampler;
+    std::thread processingThread;
+    std::thread resamplingThread;
+    // Runs the resampling thread while set; cleared when tracking stops or the controller is lost
+    std::atomic<bool> resampling{false};
+    FrameRecorder frameRecorder;
+    // Only touched from the processing thread
+    DeviceClock deviceClock;
+    TrackerMetrics metrics;
+    // Filters and tracking ids per hand
+    std::unique_ptr<HandStateTable> hands;
+    // Running per-channel aggregates, summarised next to the CSV at stop
+    std::unique_ptr<SessionStatistics> statistics;
+    // Hands and metric values of the latest frame, for the console dashboard
+    DashboardFeed dashboardFeed;
+    // Exercise events from the unfiltered channels; events is reused every frame
+    std::unique_ptr<EventDetector> eventDetector;
+    std::vector<DetectedEvent> events;
+
+    // Value columns of the session logs, from the exercise and joint angle source
+    std::unique_ptr<SessionColumns> columns;
+    // Each CSV row is built in csvRow's buffer, then handed to the writer
+    // thread; processing never allocates for a row or waits for the disk
+    std::unique_ptr<RowFormatter> csvRow;
+    AsyncFileWriter logFile;
+    std::string logFilePath;
+    // Binary session log, when logFormat asks for one
+    SessionFileWriter binaryLog;
+    std::string binaryLogPath;
+    struct sockaddr_in oscAddr;
 
-using WsServer = websocketpp::server<websocketpp::config::asio>;
+    std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> wsConnections;
+    // Bitmask of PolicyManager streams each client has subscribed to
+    std::map<websocketpp::connection_hdl, uint32_t, std::owner_less<websocketpp::connection_hdl>> wsSubscriptions;
+    // Which messages each client receives; clients not listed get frames only
+    enum WebSocketOutput : uint32_t {
+        FrameOutput = 1,
+        EventOutput = 2
+    };
+    std::map<websocketpp::connection_hdl, uint32_t, std::owner_less<websocketpp::connection_hdl>> wsOutputs;
+    std::mutex wsMutex;
+};
 
 class LeapTracker {
 public:
-    LeapTracker(const std::string& clientName, int sessionNumber, const std::string& exerciseName, const char* oscIP, int oscPort, int wsPort);
+    LeapTracker(const std::string& clientName, int sessionNumber, const std::string& exerciseName, const char* oscIP, int oscPort, int wsPort,
+                const LeapTrackerOptions& options = LeapTrackerOptions());
     ~LeapTracker();
 
     void startTracking();
     void stopTracking();
     std::string getLatestData();
+    // Latency percentiles, dropped frames and buffer state as served on a session's /metrics
+    std::string getMetricsJson(size_t session = 0);
+    // Per-channel session statistics as served by /stats
+    std::string getStatisticsJson(size_t session = 0);
+    size_t sessionCount() const { return sessions.size(); }
 
 private:
     LEAP_CONNECTION connection;
+    // Must outlive the connection: LeapC returns blocks to it until LeapDestroyConnection
+    LeapPoolAllocator leapAllocator;
+    // Image/map point policies are only enabled while something has asked for them
+    PolicyManager policyManager;
     std::string latestData;
-    bool isTracking;
-    std::ofstream logFile;
+    std::atomic<bool> isTracking;
     std::string clientName;
     int sessionNumber;
     std::string exerciseName;
 
     void pollConnection();
-    void processFrame(const LEAP_TRACKING_EVENT* frame);
-    float calculateDistance(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2);
-    std::string getCurrentTimestamp();
+    void processFrames(TrackingSession& session);
+    void processFrame(TrackingSession& session, const LEAP_TRACKING_EVENT* frame);
     std::thread pollingThread;
 
-    float thumbIndexDistance;
-    float thumbMiddleDistance;
-    float thumbRingDistance;
-    float thumbPinkyDistance;
+    LeapTrackerOptions options;
+    std::vector<std::unique_ptr<TrackingSession>> sessions;
+    // Polling thread only: LeapC device id to session
+    std::map<uint32_t, TrackingSession*> sessionsByDevice;
+
+    // Started with tracking when options.dashboard is set
+    std::unique_ptr<ConsoleDashboard> dashboard;
+
+    // Shared WebSocket listener and OSC socket; declared after sessions so it stops first
+    std::unique_ptr<SessionManager> sessionManager;
+
+    void initialiseSession(TrackingSession& session);
+    std::string sessionFileName(const std::string& path, int index) const;
+    void attachDevice(const LEAP_DEVICE_REF& ref);
+    void detachDevice(TrackingSession& session);
+    TrackingSession* unboundSessionFor(const std::string& serial);
+    void attachDevices();
+    TrackingSession* sessionForDevice(uint32_t deviceId);
 
-    float calculateAngle(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2, const LEAP_VECTOR& p3);
-    float calculateAngleBetweenBones(const LEAP_BONE& bone1, const LEAP_BONE& bone2);
     bool fileExists(const std::string& filePath);
+    nlohmann::json statisticsReport(TrackingSession& session);
+    void writeSessionSummary(TrackingSession& session);
+    void saveCalibration(TrackingSession& session);
 
     // OSC-related members
-    int oscSocket;
-    struct sockaddr_in oscAddr;
     int oscPort;
     std::string oscIP;
-    void sendHandPresenceOsc(bool isPresent);
-    void sendOscMessage(const char* address, float value);
-
-    float calculateMakeAFistMetric(const LEAP_HAND* hand);
-    float calculatePronationSupinationMetric(const LEAP_HAND* hand);
-    float calculateWristAROMMetric(const LEAP_HAND* hand);
-
-    std::unique_ptr<WsServer> wsServer;
-    std::thread wsThread;
-    std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> wsConnections;
+    void sendHandPresenceOsc(TrackingSession& session, bool isPresent);
+    void sendOscMessage(TrackingSession& session, const char* address, float value);
 
     void initialiseWebSocket(int port);
-    void broadcastWebSocketMessage(const std::string& message);
-    void onWebSocketOpen(websocketpp::connection_hdl hdl);
-    void onWebSocketClose(websocketpp::connection_hdl hdl);
+    void broadcastWebSocketMessage(TrackingSession& session, const std::string& message,
+                                   uint32_t output = TrackingSession::FrameOutput);
+    void sendEvents(TrackingSession& session, int64_t frameTimestamp, int64_t frameEpochMicros);
+    void onWebSocketOpen(TrackingSession& session, websocketpp::connection_hdl hdl);
+    void onWebSocketClose(TrackingSession& session, websocketpp::connection_hdl hdl);
+    void onWebSocketMessage(TrackingSession& session, websocketpp::connection_hdl hdl, const std::string& payload);
+    void onHttpRequest(TrackingSession& session, const std::string& subpath, WsServer::connection_ptr con);
 };
 
 #endif /* LeapTracker_hpp */
\ No newline at end of file
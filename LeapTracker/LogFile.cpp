@@ -0,0 +1,267 @@
+//
+//  LogFile.cpp
+//  LeapTracker
+//
+#include "LogFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+#ifdef LEAPTRACKER_ZSTD
+#include <zstd.h>
+#endif
+
+LogFile::LogFile()
+    : fd(-1), part(0), partBytes(0), partRawBytes(0), compressor(nullptr) {}
+
+LogFile::~LogFile() {
+    close(false);
+#ifdef LEAPTRACKER_ZSTD
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(compressor));
+#endif
+}
+
+bool LogFile::open(const std::string& path, const Options& fileOptions, const std::string& filePreamble) {
+    close(false);
+    options = fileOptions;
+    basePath = path;
+    preamble = filePreamble;
+    counters = Stats();
+    part = 0;
+    if (options.compression == Compression::Zstd) {
+#ifdef LEAPTRACKER_ZSTD
+        if (!compressor) {
+            compressor = ZSTD_createCCtx();
+        }
+        // A whole block plus one batch, so gathering never reallocates in steady state
+        block.reserve(options.blockBytes * 2);
+#else
+        std::cerr << "Cannot compress " << path << ": built without zstd support" << std::endl;
+        return false;
+#endif
+    }
+    return openPart(Clock::now());
+}
+
+bool LogFile::write(const char* data, size_t size, Clock::time_point now) {
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = rotateIfDue(now);
+    if (fd < 0) {
+        return false;
+    }
+    if (options.compression == Compression::None) {
+        if (!writeBlock(data, size)) {
+            return false;
+        }
+        counters.rowBytes += size;
+        return ok;
+    }
+
+    if (block.empty()) {
+        blockOpened = now;
+    }
+    block.insert(block.end(), data, data + size);
+    if (block.size() >= options.blockBytes) {
+        ok = finishBlock() && ok;
+    }
+    return ok;
+}
+
+bool LogFile::rotateIfDue(Clock::time_point now) {
+    if (fd < 0) {
+        return false;
+    }
+    if ((options.rotateBytes > 0 && partBytes >= options.rotateBytes) ||
+        (options.rotateInterval.count() > 0 && now - partOpened >= options.rotateInterval)) {
+        bool ok = closePart(options.syncFinishedParts);
+        return openPart(now) && ok;
+    }
+    return true;
+}
+
+bool LogFile::poll(Clock::time_point now) {
+    if (fd < 0) {
+        return true;
+    }
+    if (options.rotateInterval.count() > 0 && now - partOpened >= options.rotateInterval) {
+        // Empty parts are not worth starting; the next write rotates
+        return finishBlock();
+    }
+    if (!block.empty() && now - blockOpened >= options.blockInterval) {
+        return finishBlock();
+    }
+    return true;
+}
+
+bool LogFile::sync() {
+    if (fd < 0) {
+        return false;
+    }
+    if (fsync(fd) != 0) {
+        std::cerr << "Failed to sync " << partFilePath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    counters.syncs++;
+    return true;
+}
+
+void LogFile::close(bool sync) {
+    if (fd >= 0) {
+        closePart(sync);
+    }
+}
+
+bool LogFile::openPart(Clock::time_point now) {
+    part++;
+    partFilePath = partPath(basePath, part);
+    if (options.compression == Compression::Zstd) {
+        partFilePath += ".zst";
+    }
+    fd = ::open(partFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << partFilePath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    counters.parts++;
+    partBytes = 0;
+    partRawBytes = 0;
+    partOpened = now;
+    blocks.clear();
+    if (preamble.empty()) {
+        return true;
+    }
+    if (options.compression == Compression::None) {
+        return writeBlock(preamble.data(), preamble.size());
+    }
+    block.assign(preamble.begin(), preamble.end());
+    return finishBlock();
+}
+
+bool LogFile::closePart(bool sync) {
+    bool ok = finishBlock();
+    if (sync) {
+        ok = this->sync() && ok;
+    }
+    if (options.compression == Compression::Zstd) {
+        ok = writeIndex() && ok;
+    }
+    ::close(fd);
+    fd = -1;
+    return ok;
+}
+
+bool LogFile::finishBlock() {
+    if (block.empty()) {
+        return true;
+    }
+    bool ok = false;
+#ifdef LEAPTRACKER_ZSTD
+    size_t bound = ZSTD_compressBound(block.size());
+    if (compressed.size() < bound) {
+        compressed.resize(bound);
+    }
+    size_t size = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(compressor), compressed.data(), compressed.size(),
+                                    block.data(), block.size(), options.compressionLevel);
+    if (ZSTD_isError(size)) {
+        std::cerr << "Failed to compress " << partFilePath << ": " << ZSTD_getErrorName(size) << std::endl;
+    } else {
+        uint64_t offset = partBytes;
+        uint64_t rawOffset = partRawBytes;
+        ok = writeBlock(compressed.data(), size);
+        if (ok) {
+            // A part's first frame is its preamble when it has one
+            if (rawOffset > 0 || preamble.empty()) {
+                counters.rowBytes += block.size();
+            }
+            blocks.push_back({ offset, size, rawOffset, block.size() });
+            partRawBytes += block.size();
+            counters.rawBytes += block.size();
+            counters.blocks++;
+        }
+    }
+#endif
+    block.clear();
+    return ok;
+}
+
+// Writes bytes as they go to disk; uncompressed they are also the raw bytes
+bool LogFile::writeBlock(const char* data, size_t size) {
+    if (!writeAll(data, size)) {
+        return false;
+    }
+    partBytes += size;
+    counters.bytesWritten += size;
+    counters.writes++;
+    if (options.compression == Compression::None) {
+        partRawBytes += size;
+        counters.rawBytes += size;
+    }
+    return true;
+}
+
+bool LogFile::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Failed to write " << partFilePath << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool LogFile::writeIndex() {
+    std::string path = indexPath(partFilePath);
+    std::ofstream index(path, std::ofstream::out | std::ofstream::trunc);
+    index << "{\n  \"compression\": \"zstd\",\n  \"rawBytes\": " << partRawBytes
+          << ",\n  \"blockFields\": [\"offset\", \"size\", \"rawOffset\", \"rawSize\"],\n  \"blocks\": [";
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const Block& b = blocks[i];
+        index << (i ? ",\n    [" : "\n    [") << b.offset << ", " << b.size << ", " << b.rawOffset << ", " << b.rawSize << "]";
+    }
+    index << "\n  ]\n}\n";
+    if (!index.flush()) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string LogFile::partPath(const std::string& path, int part) {
+    if (part <= 1) {
+        return path;
+    }
+    std::string suffix = "_part" + std::to_string(part);
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + suffix;
+    }
+    return path.substr(0, dot) + suffix + path.substr(dot);
+}
+
+LogFile::Compression LogFile::parseCompression(const std::string& name) {
+    if (name == "none") {
+        return Compression::None;
+    }
+    if (name == "zstd") {
+#ifdef LEAPTRACKER_ZSTD
+        return Compression::Zstd;
+#else
+        throw std::invalid_argument("zstd compression needs a build with -DLEAPTRACKER_ENABLE_ZSTD=ON");
+#endif
+    }
+    throw std::invalid_argument("Unknown compression: " + name);
+}
+
+// end of LogFile.cpp //
@@ -0,0 +1,128 @@
+//
+//  LogFile.hpp
+//  LeapTracker
+//
+//  The file side of AsyncFileWriter, used only from its writer thread.
+//  Batches of whole rows go to the current part of the log, either as they
+//  are or, with zstd compression, gathered into blocks of about blockBytes
+//  that are each written as an independent zstd frame. A part ends once it
+//  reaches rotateBytes on disk or has been open for rotateInterval; the next
+//  one, "<name>_part<k>.<ext>", starts with the same preamble (the CSV
+//  header or the binary file header), so every part reads on its own.
+//
+//  Compressed parts are ordinary .zst files (zstd -d reads them) and get a
+//  "<part>.index.json" listing each frame's offset and size on disk and in
+//  the decompressed file, so blocks can be found and decompressed in
+//  parallel. The preamble is a frame of its own and every other frame holds
+//  whole rows. A part cut short by a crash has no index and loses the block
+//  being gathered; LeapLogDecompress rebuilds the index by walking the
+//  frame headers.
+//
+#ifndef LogFile_hpp
+#define LogFile_hpp
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class LogFile {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Compression {
+        None,
+        Zstd       // needs a build with LEAPTRACKER_ENABLE_ZSTD
+    };
+
+    struct Options {
+        Compression compression = Compression::None;
+        int compressionLevel = 3;
+        size_t blockBytes = 1 << 20;                        // uncompressed bytes per zstd frame
+        std::chrono::milliseconds blockInterval{5000};      // a frame is finished at least this often
+        uint64_t rotateBytes = 0;                           // start a new part at this size on disk; 0 never
+        std::chrono::seconds rotateInterval{0};             // or after this long; 0 never
+        bool syncFinishedParts = true;                      // fsync each part as it is closed
+    };
+
+    // Totals over every part
+    struct Stats {
+        uint64_t bytesWritten = 0;      // on disk
+        uint64_t rawBytes = 0;          // before compression, preambles included
+        uint64_t rowBytes = 0;          // of the rows written, all in the file on disk (finished frames)
+        uint64_t writes = 0;
+        uint64_t syncs = 0;
+        uint64_t blocks = 0;            // zstd frames
+        uint64_t parts = 0;
+    };
+
+    // One zstd frame of a compressed part
+    struct Block {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t rawOffset;
+        uint64_t rawSize;
+    };
+
+    LogFile();
+    ~LogFile();
+
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    // Creates the first part: path itself, plus ".zst" when compressing
+    bool open(const std::string& path, const Options& options, const std::string& preamble);
+    bool isOpen() const { return fd >= 0; }
+    // The part being written
+    const std::string& path() const { return partFilePath; }
+    // Bytes of that part on disk; with compression, finished frames only
+    uint64_t partSize() const { return partBytes; }
+    bool isCompressed() const { return options.compression == Compression::Zstd; }
+
+    // Appends a batch of whole rows, first starting a new part if this one is due
+    bool write(const char* data, size_t size, Clock::time_point now);
+    // Starts the next part if this one is due; lets the caller record the new part before rows go into it
+    bool rotateIfDue(Clock::time_point now);
+    // Called when there is nothing to write: finishes a block or part that is due
+    bool poll(Clock::time_point now);
+    bool sync();
+    // Finishes the last block and part; syncs them if sync is set
+    void close(bool sync);
+
+    const Stats& stats() const { return counters; }
+
+    // Name of part k (1-based) of a log: path itself for the first part
+    static std::string partPath(const std::string& path, int part);
+    static std::string indexPath(const std::string& partPath) { return partPath + ".index.json"; }
+    static Compression parseCompression(const std::string& name);
+
+private:
+    Options options;
+    std::string basePath;
+    std::string preamble;
+    std::string partFilePath;
+    int fd;
+    int part;
+    uint64_t partBytes;             // on disk, this part
+    uint64_t partRawBytes;          // decompressed, this part
+    Clock::time_point partOpened;
+
+    // Compression: rows gathered for the next frame, and that frame's blocks so far
+    std::vector<char> block;
+    Clock::time_point blockOpened;
+    std::vector<char> compressed;
+    std::vector<Block> blocks;
+    void* compressor;
+
+    Stats counters;
+
+    bool openPart(Clock::time_point now);
+    bool closePart(bool sync);
+    bool writeBlock(const char* data, size_t size);
+    bool finishBlock();
+    bool writeAll(const char* data, size_t size);
+    bool writeIndex();
+};
+
+#endif /* LogFile_hpp */
@@ -0,0 +1,185 @@
+//
+//  PolicyManager.cpp
+//  LeapTracker
+//
+#include "PolicyManager.hpp"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+PolicyManager::PolicyManager()
+    : refCounts(), requestedFlags(0), appliedFlags(0), servicePolicy(0), connected(false), dirty(false),
+      enabledTime(), enabled()
+{
+    for (int i = 0; i < StreamCount; i++) {
+        streamBytes[i] = 0;
+    }
+}
+
+bool PolicyManager::parseStream(const std::string& name, Stream& stream) {
+    for (int i = BackgroundFrames; i < StreamCount; i++) {
+        if (name == streamName(static_cast<Stream>(i))) {
+            stream = static_cast<Stream>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* PolicyManager::streamName(Stream stream) {
+    switch (stream) {
+        case Tracking: return "tracking";
+        case BackgroundFrames: return "background_frames";
+        default: return "unknown";
+    }
+}
+
+uint64_t PolicyManager::policyFlag(Stream stream) {
+    switch (stream) {
+        case BackgroundFrames: return eLeapPolicyFlag_BackgroundFrames;
+        default: return 0;
+    }
+}
+
+void PolicyManager::acquire(Stream stream) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (refCounts[stream]++ == 0) {
+        requestedFlags |= policyFlag(stream);
+        dirty = true;
+    }
+}
+
+void PolicyManager::release(Stream stream) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (refCounts[stream] == 0) {
+        return;
+    }
+    if (--refCounts[stream] == 0) {
+        requestedFlags &= ~policyFlag(stream);
+        dirty = true;
+    }
+}
+
+bool PolicyManager::isRequested(Stream stream) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return refCounts[stream] > 0;
+}
+
+void PolicyManager::onConnected(LEAP_CONNECTION connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        connected = true;
+        setEnabled(Tracking, true, Clock::now());
+        // Start from a known state: explicitly clear anything nobody has asked for
+        uint64_t managed = 0;
+        for (int i = BackgroundFrames; i < StreamCount; i++) {
+            managed |= policyFlag(static_cast<Stream>(i));
+        }
+        appliedFlags = managed & ~requestedFlags;
+    }
+    dirty = true;
+    apply(connection);
+}
+
+void PolicyManager::onConnectionLost() {
+    std::lock_guard<std::mutex> lock(mutex);
+    connected = false;
+    Clock::time_point now = Clock::now();
+    for (int i = 0; i < StreamCount; i++) {
+        setEnabled(static_cast<Stream>(i), false, now);
+    }
+}
+
+void PolicyManager::onPolicyEvent(const LEAP_POLICY_EVENT* event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    servicePolicy = event->current_policy;
+}
+
+void PolicyManager::apply(LEAP_CONNECTION connection) {
+    if (!dirty.exchange(false)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!connected) {
+        dirty = true;
+        return;
+    }
+
+    uint64_t set = requestedFlags & ~appliedFlags;
+    uint64_t clear = appliedFlags & ~requestedFlags;
+    if (set == 0 && clear == 0) {
+        return;
+    }
+
+    eLeapRS result = LeapSetPolicyFlags(connection, set, clear);
+    if (result != eLeapRS_Success) {
+        std::cerr << "Failed to set policy flags: " << result << std::endl;
+        dirty = true;
+        return;
+    }
+
+    appliedFlags = requestedFlags;
+    Clock::time_point now = Clock::now();
+    for (int i = BackgroundFrames; i < StreamCount; i++) {
+        Stream stream = static_cast<Stream>(i);
+        setEnabled(stream, (appliedFlags & policyFlag(stream)) != 0, now);
+    }
+    std::cout << "Policy flags updated (set 0x" << std::hex << set << ", clear 0x" << clear << std::dec << ")" << std::endl;
+}
+
+void PolicyManager::recordBytes(Stream stream, uint64_t bytes) {
+    streamBytes[stream].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void PolicyManager::recordEvent(const LEAP_CONNECTION_MESSAGE& msg) {
+    switch (msg.type) {
+        case eLeapEventType_Tracking:
+            recordBytes(Tracking, sizeof(LEAP_TRACKING_EVENT) + msg.tracking_event->nHands * sizeof(LEAP_HAND));
+            break;
+        default:
+            break;
+    }
+}
+
+double PolicyManager::bytesPerSecond(Stream stream) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Clock::duration active = enabledTime[stream];
+    if (enabled[stream]) {
+        active += Clock::now() - enabledSince[stream];
+    }
+    double seconds = std::chrono::duration<double>(active).count();
+    return seconds > 0 ? streamBytes[stream].load(std::memory_order_relaxed) / seconds : 0.0;
+}
+
+std::string PolicyManager::report() const {
+    std::stringstream ss;
+    ss << "Stream cost:";
+    for (int i = 0; i < StreamCount; i++) {
+        Stream stream = static_cast<Stream>(i);
+        if (!isMetered(stream)) {
+            continue;
+        }
+        ss << " " << streamName(stream) << "=" << std::fixed << std::setprecision(1)
+           << bytesPerSecond(stream) / 1024.0 << " KiB/s";
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ss << " (service policy 0x" << std::hex << servicePolicy << std::dec << ")";
+    }
+    return ss.str();
+}
+
+void PolicyManager::setEnabled(Stream stream, bool on, Clock::time_point now) {
+    if (on == enabled[stream]) {
+        return;
+    }
+    if (on) {
+        enabledSince[stream] = now;
+    } else {
+        enabledTime[stream] += now - enabledSince[stream];
+    }
+    enabled[stream] = on;
+}
+
+// end of PolicyManager.cpp //
@@ -0,0 +1,79 @@
+//
+//  PolicyManager.hpp
+//  LeapTracker
+//
+//  Reference-counted LeapC policy negotiation. Outputs (WebSocket clients,
+//  recorders, command-line requests) acquire the optional streams they need;
+//  a stream's policy flag is only set while at least one holder remains.
+//  Only streams the tracker actually uses are offered: camera images and map
+//  points are not forwarded anywhere, so enabling them would only cost
+//  bandwidth.
+//  The polling thread pushes pending changes to LeapC and attributes the
+//  bytes each stream delivers so its cost can be reported.
+//
+#ifndef PolicyManager_hpp
+#define PolicyManager_hpp
+
+#include "LeapC.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+class PolicyManager {
+public:
+    enum Stream {
+        Tracking,          // always on, tracked only for comparison
+        BackgroundFrames,  // keeps frames coming while another application has focus
+        StreamCount
+    };
+
+    PolicyManager();
+
+    static bool parseStream(const std::string& name, Stream& stream);
+    static const char* streamName(Stream stream);
+    static uint64_t policyFlag(Stream stream);
+    // Whether the stream's traffic can be told apart from the rest. Background
+    // frames arrive as ordinary tracking events, so they have no cost of their own
+    static bool isMetered(Stream stream) { return stream == Tracking; }
+
+    // Safe to call from any thread
+    void acquire(Stream stream);
+    void release(Stream stream);
+    bool isRequested(Stream stream) const;
+
+    // Polling thread only
+    void onConnected(LEAP_CONNECTION connection);
+    void onConnectionLost();
+    void onPolicyEvent(const LEAP_POLICY_EVENT* event);
+    void apply(LEAP_CONNECTION connection);
+    void recordBytes(Stream stream, uint64_t bytes);
+    void recordEvent(const LEAP_CONNECTION_MESSAGE& msg);
+
+    // Average bytes per second delivered by a metered stream while it was enabled
+    double bytesPerSecond(Stream stream) const;
+    std::string report() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    mutable std::mutex mutex;
+    int refCounts[StreamCount];
+    uint64_t requestedFlags;
+    uint64_t appliedFlags;
+    uint32_t servicePolicy;
+    bool connected;
+    std::atomic<bool> dirty;
+
+    std::atomic<uint64_t> streamBytes[StreamCount];
+
+    // Enabled-time accounting, guarded by mutex
+    Clock::duration enabledTime[StreamCount];
+    Clock::time_point enabledSince[StreamCount];
+    bool enabled[StreamCount];
+
+    void setEnabled(Stream stream, bool on, Clock::time_point now);
+};
+
+#endif /* PolicyManager_hpp */
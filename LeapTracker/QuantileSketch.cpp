@@ -0,0 +1,125 @@
+//
+//  QuantileSketch.cpp
+//  LeapTracker
+//
+#include "QuantileSketch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+    : accuracy(relativeAccuracy), zeroCount(0)
+{
+    if (!(relativeAccuracy > 0 && relativeAccuracy < 1)) {
+        throw std::invalid_argument("Quantile sketch accuracy must be between 0 and 1");
+    }
+    gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+    logGamma = std::log(gamma);
+}
+
+int QuantileSketch::key(double magnitude) const {
+    return static_cast<int>(std::ceil(std::log(magnitude) / logGamma));
+}
+
+// Midpoint of the bucket (gamma^(key-1), gamma^key], which is within
+// the relative accuracy of every value in it
+double QuantileSketch::value(int key) const {
+    return 2.0 * std::pow(gamma, key) / (1.0 + gamma);
+}
+
+void QuantileSketch::Store::add(int key, uint64_t n) {
+    if (bins.empty()) {
+        offset = key;
+        bins.push_back(0);
+    }
+    int lo = std::min(key, offset);
+    int hi = std::max(key, offset + static_cast<int>(bins.size()) - 1);
+    if (hi - lo + 1 > kMaxBins) {
+        lo = hi - kMaxBins + 1;
+    }
+
+    if (lo < offset) {
+        bins.insert(bins.begin(), offset - lo, 0);
+        offset = lo;
+    } else if (lo > offset) {
+        // Fold the buckets now out of range into the lowest remaining one
+        size_t folded = std::min(static_cast<size_t>(lo - offset), bins.size());
+        uint64_t foldedCount = 0;
+        for (size_t i = 0; i < folded; i++) {
+            foldedCount += bins[i];
+        }
+        bins.erase(bins.begin(), bins.begin() + folded);
+        offset = lo;
+        if (bins.empty()) {
+            bins.push_back(0);
+        }
+        bins[0] += foldedCount;
+    }
+    if (hi >= offset + static_cast<int>(bins.size())) {
+        bins.resize(hi - offset + 1, 0);
+    }
+
+    bins[std::max(key, lo) - offset] += n;
+    total += n;
+}
+
+void QuantileSketch::add(double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+    if (value > kMinMagnitude) {
+        positive.add(key(value), 1);
+    } else if (value < -kMinMagnitude) {
+        negative.add(key(-value), 1);
+    } else {
+        zeroCount++;
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.accuracy != accuracy) {
+        throw std::invalid_argument("Cannot merge quantile sketches with different accuracies");
+    }
+    for (size_t i = 0; i < other.positive.bins.size(); i++) {
+        if (other.positive.bins[i]) {
+            positive.add(other.positive.offset + static_cast<int>(i), other.positive.bins[i]);
+        }
+    }
+    for (size_t i = 0; i < other.negative.bins.size(); i++) {
+        if (other.negative.bins[i]) {
+            negative.add(other.negative.offset + static_cast<int>(i), other.negative.bins[i]);
+        }
+    }
+    zeroCount += other.zeroCount;
+}
+
+double QuantileSketch::quantile(double q) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    double rank = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(n - 1);
+
+    // Ascending order: most negative first, then zero, then positive
+    uint64_t cumulative = 0;
+    for (size_t i = negative.bins.size(); i-- > 0;) {
+        cumulative += negative.bins[i];
+        if (cumulative > rank) {
+            return -value(negative.offset + static_cast<int>(i));
+        }
+    }
+    cumulative += zeroCount;
+    if (cumulative > rank) {
+        return 0.0;
+    }
+    for (size_t i = 0; i < positive.bins.size(); i++) {
+        cumulative += positive.bins[i];
+        if (cumulative > rank) {
+            return value(positive.offset + static_cast<int>(i));
+        }
+    }
+    return value(positive.offset + static_cast<int>(positive.bins.size()) - 1);
+}
+
+// end of QuantileSketch.cpp //
@@ -0,0 +1,56 @@
+//
+//  QuantileSketch.hpp
+//  LeapTracker
+//
+//  DDSketch-style quantile sketch (Masson et al. 2019): values are counted
+//  in logarithmic buckets, so any quantile is returned within a fixed
+//  relative error of the true value, updates are O(1) and two sketches with
+//  the same accuracy merge by adding bucket counts. Positive and negative
+//  values have their own buckets; magnitudes below kMinMagnitude count as 0.
+//
+#ifndef QuantileSketch_hpp
+#define QuantileSketch_hpp
+
+#include <cstdint>
+#include <vector>
+
+class QuantileSketch {
+public:
+    static constexpr double kMinMagnitude = 1e-6;
+
+    // relativeAccuracy 0.01 returns quantiles within 1% of the true value
+    explicit QuantileSketch(double relativeAccuracy = 0.01);
+
+    void add(double value);
+    // Throws std::invalid_argument if the sketches' accuracies differ
+    void merge(const QuantileSketch& other);
+
+    uint64_t count() const { return positive.total + negative.total + zeroCount; }
+    double relativeAccuracy() const { return accuracy; }
+    // Value at quantile q (0..1); NaN when empty
+    double quantile(double q) const;
+
+private:
+    // Buckets cover keys offset..offset + bins.size() - 1. When the range
+    // would exceed kMaxBins the smallest magnitudes are folded together.
+    struct Store {
+        static const int kMaxBins = 2048;
+        std::vector<uint64_t> bins;
+        int offset = 0;
+        uint64_t total = 0;
+
+        void add(int key, uint64_t n);
+    };
+
+    double accuracy;
+    double gamma;
+    double logGamma;
+    Store positive;
+    Store negative;
+    uint64_t zeroCount;
+
+    int key(double magnitude) const;
+    double value(int key) const;
+};
+
+#endif /* QuantileSketch_hpp */
@@ -0,0 +1,79 @@
+//
+//  RowFormatter.cpp
+//  LeapTracker
+//
+#include "RowFormatter.hpp"
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+RowFormatter::RowFormatter(const std::string& prefix, size_t fieldCount, size_t extraChars, FloatFormat format)
+    : floatFormat(format), prefixLength(prefix.size()), length(prefix.size())
+{
+    if (format.precision < 0 || format.precision > kMaxPrecision) {
+        throw std::invalid_argument("Float precision must be between 0 and " + std::to_string(kMaxPrecision));
+    }
+    // Separator plus the widest field for every number, and the newline
+    buffer.resize(prefix.size() + extraChars + fieldCount * (kMaxFloatChars + 1) + 1);
+    memcpy(buffer.data(), prefix.data(), prefix.size());
+}
+
+void RowFormatter::append(const char* text, size_t size) {
+    memcpy(buffer.data() + length, text, size);
+    length += size;
+}
+
+void RowFormatter::appendField(float value) {
+    buffer[length++] = ',';
+    char* out = buffer.data() + length;
+    char* last = out + kMaxFloatChars;
+    std::to_chars_result result;
+    switch (floatFormat.style) {
+        case FloatFormat::Style::Shortest:
+            result = std::to_chars(out, last, value);
+            break;
+        case FloatFormat::Style::Fixed:
+            result = std::to_chars(out, last, value, std::chars_format::fixed, floatFormat.precision);
+            break;
+        default:
+            // %g with precision 0 means 1, as a stream prints it
+            result = std::to_chars(out, last, value, std::chars_format::general, floatFormat.precision);
+            break;
+    }
+    length = static_cast<size_t>(result.ptr - buffer.data());
+}
+
+void RowFormatter::appendField(int64_t value) {
+    buffer[length++] = ',';
+    std::to_chars_result result = std::to_chars(buffer.data() + length, buffer.data() + length + kMaxFloatChars, value);
+    length = static_cast<size_t>(result.ptr - buffer.data());
+}
+
+RowFormatter::FloatFormat RowFormatter::parseFloatFormat(const std::string& text) {
+    FloatFormat format;
+    std::string style = text.substr(0, text.find(':'));
+    if (style == "general") {
+        format.style = FloatFormat::Style::General;
+    } else if (style == "shortest") {
+        format.style = FloatFormat::Style::Shortest;
+    } else if (style == "fixed") {
+        format.style = FloatFormat::Style::Fixed;
+        format.precision = 3;
+    } else {
+        throw std::invalid_argument("Unknown float format: " + text);
+    }
+    if (text.find(':') != std::string::npos) {
+        std::string digits = text.substr(text.find(':') + 1);
+        if (format.style == FloatFormat::Style::Shortest || digits.empty() ||
+            digits.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::invalid_argument("Invalid float format: " + text);
+        }
+        format.precision = std::stoi(digits);
+        if (format.precision > kMaxPrecision) {
+            throw std::invalid_argument("Float precision must be at most " + std::to_string(kMaxPrecision) + ": " + text);
+        }
+    }
+    return format;
+}
+
+// end of RowFormatter.cpp //
@@ -0,0 +1,60 @@
+//
+//  RowFormatter.hpp
+//  LeapTracker
+//
+//  Builds CSV rows in a buffer allocated once per session, with std::to_chars
+//  instead of a std::stringstream per row. Formatting a row allocates
+//  nothing and ignores the locale. The default float format (six significant
+//  digits, as printf %g) writes the same text as the stream it replaces;
+//  shortest round-trip and fixed decimals are available with --csv-floats.
+//
+#ifndef RowFormatter_hpp
+#define RowFormatter_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RowFormatter {
+public:
+    struct FloatFormat {
+        enum class Style {
+            General,    // precision significant digits, like operator<< on a stream
+            Shortest,   // fewest digits that read back to the same float
+            Fixed       // precision digits after the point
+        };
+        Style style = Style::General;
+        int precision = 6;
+    };
+
+    // Longest field a float can take in any format, without the separator
+    static const int kMaxPrecision = 9;
+    static const size_t kMaxFloatChars = 48 + kMaxPrecision;
+
+    // prefix starts every row (e.g. "client,session,exercise,"); rows hold up
+    // to extraChars of appended text plus fieldCount numeric fields
+    RowFormatter(const std::string& prefix, size_t fieldCount, size_t extraChars, FloatFormat format);
+
+    // Starts a new row with the prefix
+    void begin() { length = prefixLength; }
+    void append(const char* text, size_t size);
+    // A separator and then the value
+    void appendField(float value);
+    void appendField(int64_t value);
+    void end() { buffer[length++] = '\n'; }
+
+    const char* data() const { return buffer.data(); }
+    size_t size() const { return length; }
+
+    // "general:<digits>", "shortest" or "fixed:<decimals>"
+    static FloatFormat parseFloatFormat(const std::string& text);
+
+private:
+    FloatFormat floatFormat;
+    std::vector<char> buffer;
+    size_t prefixLength;
+    size_t length;
+};
+
+#endif /* RowFormatter_hpp */
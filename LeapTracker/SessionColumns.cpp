@@ -0,0 +1,50 @@
+//
+//  SessionColumns.cpp
+//  LeapTracker
+//
+#include "SessionColumns.hpp"
+#include "HandChannels.hpp"
+
+const char* const SessionColumns::kCsvPrefix = "Client Name,Session Number,Exercise Name,Timestamp,Hand";
+
+SessionColumns::SessionColumns(const ExercisePipeline& pipeline, bool abduction) {
+    auto add = [this](const std::string& name, int channel) {
+        names.push_back(name);
+        channels.push_back(channel);
+    };
+
+    // Finger positions, joint angles, wrist and palm data
+    for (int c = HandChannels::Tips; c < HandChannels::ThumbDistances; c++) {
+        add(HandChannels::columnName(c), c);
+    }
+    // Hand orientation is the palm's, written again under its own name
+    add("Hand Roll", HandChannels::PalmAngles);
+    add("Hand Pitch", HandChannels::PalmAngles + 1);
+    add("Hand Yaw", HandChannels::PalmAngles + 2);
+    for (int c = HandChannels::ThumbDistances; c < HandChannels::Metrics; c++) {
+        add(HandChannels::columnName(c), c);
+    }
+    for (size_t m = 0; m < pipeline.metricCount; m++) {
+        add(metricInfo(pipeline.metrics[m]).csvColumn, HandChannels::Metrics + static_cast<int>(m));
+    }
+    if (abduction) {
+        for (int c = HandChannels::Abduction; c < HandChannels::Count; c++) {
+            add(HandChannels::columnName(c), c);
+        }
+    }
+}
+
+SessionColumns::SessionColumns(const std::vector<std::string>& names, const std::vector<int>& channels)
+    : names(names), channels(channels) {}
+
+std::string SessionColumns::csvHeader() const {
+    std::string header = kCsvPrefix;
+    for (const std::string& name : names) {
+        header += ",";
+        header += name;
+    }
+    header += "\n";
+    return header;
+}
+
+// end of SessionColumns.cpp //
@@ -0,0 +1,34 @@
+//
+//  SessionColumns.hpp
+//  LeapTracker
+//
+//  The per-hand value columns of a session log, in CSV order, after the
+//  fixed Client Name, Session Number, Exercise Name, Timestamp and Hand
+//  columns. The CSV header and rows, the binary session format's schema and
+//  the binary-to-CSV converter all come from this one list.
+//
+#ifndef SessionColumns_hpp
+#define SessionColumns_hpp
+
+#include "ExerciseMetrics.hpp"
+#include <string>
+#include <vector>
+
+struct SessionColumns {
+    static const char* const kCsvPrefix;    // the fixed columns, comma separated
+
+    std::vector<std::string> names;         // CSV column names
+    std::vector<int> channels;              // HandChannels index of each column
+
+    // The pipeline's metrics are included in pipeline order, abduction only when
+    // joint angles come from bone rotations
+    SessionColumns(const ExercisePipeline& pipeline, bool abduction);
+    // Columns read back from a file's schema
+    SessionColumns(const std::vector<std::string>& names, const std::vector<int>& channels);
+
+    size_t size() const { return names.size(); }
+    // kCsvPrefix and the column names, newline terminated
+    std::string csvHeader() const;
+};
+
+#endif /* SessionColumns_hpp */
@@ -0,0 +1,194 @@
+//
+//  SessionFile.cpp
+//  LeapTracker
+//
+#include "SessionFile.hpp"
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+size_t roundUp8(size_t n) {
+    return (n + 7) / 8 * 8;
+}
+
+void copyName(char* destination, size_t capacity, const std::string& name) {
+    memset(destination, 0, capacity);
+    strncpy(destination, name.c_str(), capacity - 1);
+}
+
+std::string nameOf(const char* field, size_t capacity) {
+    return std::string(field, strnlen(field, capacity));
+}
+
+}  // namespace
+
+SessionLogFormat parseSessionLogFormat(const std::string& name) {
+    if (name == "csv") {
+        return SessionLogFormat::Csv;
+    }
+    if (name == "binary") {
+        return SessionLogFormat::Binary;
+    }
+    if (name == "both") {
+        return SessionLogFormat::Both;
+    }
+    throw std::invalid_argument("Unknown log format: " + name);
+}
+
+std::string sessionFilePathFor(const std::string& csvPath) {
+    const std::string extension = ".csv";
+    if (csvPath.size() >= extension.size() && csvPath.compare(csvPath.size() - extension.size(), extension.size(), extension) == 0) {
+        return csvPath.substr(0, csvPath.size() - extension.size()) + ".ltsb";
+    }
+    return csvPath + ".ltsb";
+}
+
+bool SessionFileWriter::open(const std::string& path, const std::string& clientName, int sessionNumber,
+                             const std::string& exerciseName, const SessionColumns& columns,
+                             const AsyncFileWriter::Options& options) {
+    SessionFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SESSION_FILE_MAGIC;
+    header.version = SESSION_FILE_VERSION;
+    header.columnCount = static_cast<uint32_t>(columns.size());
+    header.headerBytes = static_cast<uint32_t>(roundUp8(sizeof(SessionFileHeader) + columns.size() * sizeof(SessionFileColumn)));
+    header.recordBytes = static_cast<uint32_t>(roundUp8(sizeof(SessionRecordHeader) + columns.size() * sizeof(float)));
+    header.sessionNumber = sessionNumber;
+    header.createdEpochMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    copyName(header.clientName, sizeof(header.clientName), clientName);
+    copyName(header.exerciseName, sizeof(header.exerciseName), exerciseName);
+
+    std::string headerBytes(header.headerBytes, '\0');
+    memcpy(&headerBytes[0], &header, sizeof(header));
+    for (size_t i = 0; i < columns.size(); i++) {
+        SessionFileColumn column;
+        copyName(column.name, sizeof(column.name), columns.names[i]);
+        column.channel = static_cast<uint32_t>(columns.channels[i]);
+        column.offset = static_cast<uint32_t>(sizeof(SessionRecordHeader) + i * sizeof(float));
+        memcpy(&headerBytes[sizeof(header) + i * sizeof(column)], &column, sizeof(column));
+    }
+    // Every part of a rotated log starts with the header
+    if (!file.open(path, options, headerBytes)) {
+        return false;
+    }
+
+    channels = columns.channels;
+    record.assign(header.recordBytes, 0);
+    return true;
+}
+
+void SessionFileWriter::append(int64_t deviceTimestamp, int64_t epochMicros, const LEAP_HAND& hand, const HandChannels& values) {
+    SessionRecordHeader recordHeader = { deviceTimestamp, epochMicros, hand.id, static_cast<int32_t>(hand.type) };
+    memcpy(record.data(), &recordHeader, sizeof(recordHeader));
+    float* out = reinterpret_cast<float*>(record.data() + sizeof(recordHeader));
+    for (size_t i = 0; i < channels.size(); i++) {
+        out[i] = values[channels[i]];
+    }
+    file.append(record.data(), record.size());
+}
+
+SessionFileReader::SessionFileReader() : data(nullptr), size(0), fileHeader(nullptr), records(0) {}
+
+SessionFileReader::~SessionFileReader() {
+    close();
+}
+
+bool SessionFileReader::fail(const std::string& message) {
+    lastError = message;
+    close();
+    return false;
+}
+
+bool SessionFileReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return fail("Cannot open " + path + ": " + strerror(errno));
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(SessionFileHeader)) {
+        ::close(fd);
+        return fail("Not a session file (too short): " + path);
+    }
+    size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        size = 0;
+        return fail("Cannot map " + path + ": " + strerror(errno));
+    }
+    data = static_cast<const char*>(mapping);
+    fileHeader = reinterpret_cast<const SessionFileHeader*>(data);
+
+    const SessionFileHeader& h = *fileHeader;
+    if (h.magic != SESSION_FILE_MAGIC) {
+        return fail("Not a session file: " + path);
+    }
+    if (h.version != SESSION_FILE_VERSION) {
+        return fail("Unsupported session file version " + std::to_string(h.version) + ": " + path);
+    }
+    if (h.headerBytes < sizeof(SessionFileHeader) + h.columnCount * sizeof(SessionFileColumn) || h.headerBytes > size ||
+        h.recordBytes < sizeof(SessionRecordHeader) + h.columnCount * sizeof(float)) {
+        return fail("Corrupt session file header: " + path);
+    }
+
+    columnTable.resize(h.columnCount);
+    memcpy(columnTable.data(), data + sizeof(SessionFileHeader), h.columnCount * sizeof(SessionFileColumn));
+    for (const SessionFileColumn& column : columnTable) {
+        if (column.offset + sizeof(float) > h.recordBytes) {
+            return fail("Corrupt session file column table: " + path);
+        }
+    }
+    records = (size - h.headerBytes) / h.recordBytes;
+
+    // Columns are read front to back
+    madvise(const_cast<char*>(data), size, MADV_SEQUENTIAL);
+    return true;
+}
+
+void SessionFileReader::close() {
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    fileHeader = nullptr;
+    columnTable.clear();
+    records = 0;
+}
+
+std::string SessionFileReader::clientName() const {
+    return nameOf(fileHeader->clientName, sizeof(fileHeader->clientName));
+}
+
+std::string SessionFileReader::exerciseName() const {
+    return nameOf(fileHeader->exerciseName, sizeof(fileHeader->exerciseName));
+}
+
+SessionColumns SessionFileReader::columns() const {
+    std::vector<std::string> names;
+    std::vector<int> channels;
+    for (const SessionFileColumn& column : columnTable) {
+        names.push_back(nameOf(column.name, sizeof(column.name)));
+        channels.push_back(static_cast<int>(column.channel));
+    }
+    return SessionColumns(names, channels);
+}
+
+int SessionFileReader::columnIndex(const std::string& name) const {
+    for (size_t i = 0; i < columnTable.size(); i++) {
+        if (nameOf(columnTable[i].name, sizeof(columnTable[i].name)) == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// end of SessionFile.cpp //
@@ -0,0 +1,164 @@
+//
+//  SessionFile.hpp
+//  LeapTracker
+//
+//  Binary session logs (--log-format binary or both): the same rows as the
+//  CSV, as fixed-size records instead of decimal text, so analysis can map
+//  the file and read columns directly. SessionFileReader maps a file and
+//  exposes each column as a typed, strided span over the records; the
+//  LeapSessionToCsv tool turns a file back into the CSV layout.
+//
+//  Layout (little-endian):
+//    SessionFileHeader
+//    SessionFileColumn[columnCount]
+//    zero padding up to headerBytes (a multiple of 8)
+//    repeated { SessionRecordHeader, float[columnCount], zero padding up to recordBytes }
+//
+//  A file cut short by a crash is still readable: a partial last record is
+//  ignored. Each part of a rotated log is a complete file with its own
+//  header; compressed parts are read after LeapLogDecompress.
+//
+#ifndef SessionFile_hpp
+#define SessionFile_hpp
+
+#include "LeapC.h"
+#include "AsyncFileWriter.hpp"
+#include "HandChannels.hpp"
+#include "SessionColumns.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Session files are little-endian and are read and written in place"
+#endif
+
+#define SESSION_FILE_MAGIC 0x4253544C  // "LTSB"
+#define SESSION_FILE_VERSION 1
+
+// Which session logs the tracker writes (--log-format)
+enum class SessionLogFormat {
+    Csv,
+    Binary,
+    Both
+};
+
+SessionLogFormat parseSessionLogFormat(const std::string& name);
+inline bool writesCsv(SessionLogFormat format) { return format != SessionLogFormat::Binary; }
+inline bool writesBinary(SessionLogFormat format) { return format != SessionLogFormat::Csv; }
+// "<name>.ltsb" for a CSV log "<name>.csv"
+std::string sessionFilePathFor(const std::string& csvPath);
+
+struct SessionFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerBytes;           // offset of the first record
+    uint32_t recordBytes;
+    uint32_t columnCount;
+    int32_t sessionNumber;
+    int64_t createdEpochMicros;
+    char clientName[64];
+    char exerciseName[64];
+};
+
+struct SessionFileColumn {
+    char name[48];                  // CSV column name
+    uint32_t channel;               // HandChannels index the values came from
+    uint32_t offset;                // of the float within a record
+};
+
+struct SessionRecordHeader {
+    int64_t deviceTimestamp;        // LeapC microseconds at capture
+    int64_t epochMicros;            // the same instant in Unix time, as in the CSV
+    uint32_t handId;                // LEAP_HAND.id
+    int32_t handType;               // eLeapHandType, the CSV's Hand column
+};
+
+// One column of a mapped file: element i is at base + i * stride
+template <typename T>
+class ColumnSpan {
+public:
+    ColumnSpan() : base(nullptr), stride(0), count(0) {}
+    ColumnSpan(const char* base, size_t stride, size_t count) : base(base), stride(stride), count(count) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T operator[](size_t i) const {
+        T value;
+        memcpy(&value, base + i * stride, sizeof(T));
+        return value;
+    }
+
+private:
+    const char* base;
+    size_t stride;
+    size_t count;
+};
+
+class SessionFileWriter {
+public:
+    bool open(const std::string& path, const std::string& clientName, int sessionNumber, const std::string& exerciseName,
+              const SessionColumns& columns, const AsyncFileWriter::Options& options);
+    bool isOpen() const { return file.isOpen(); }
+    const std::string& path() const { return file.path(); }
+
+    void append(int64_t deviceTimestamp, int64_t epochMicros, const LEAP_HAND& hand, const HandChannels& channels);
+    void close() { file.close(); }
+
+    AsyncFileWriter::Stats stats() const { return file.stats(); }
+
+private:
+    AsyncFileWriter file;
+    std::vector<int> channels;
+    std::vector<char> record;
+};
+
+class SessionFileReader {
+public:
+    SessionFileReader();
+    ~SessionFileReader();
+
+    SessionFileReader(const SessionFileReader&) = delete;
+    SessionFileReader& operator=(const SessionFileReader&) = delete;
+
+    // Maps the file read-only; on failure returns false and error() says why
+    bool open(const std::string& path);
+    void close();
+    const std::string& error() const { return lastError; }
+
+    const SessionFileHeader& header() const { return *fileHeader; }
+    std::string clientName() const;
+    std::string exerciseName() const;
+    size_t recordCount() const { return records; }
+
+    // The file's schema, usable for CSV output
+    SessionColumns columns() const;
+    size_t columnCount() const { return columnTable.size(); }
+    const SessionFileColumn& column(size_t index) const { return columnTable[index]; }
+    // Index of the column with this CSV name, or -1
+    int columnIndex(const std::string& name) const;
+
+    ColumnSpan<int64_t> deviceTimestamps() const { return field<int64_t>(offsetof(SessionRecordHeader, deviceTimestamp)); }
+    ColumnSpan<int64_t> epochMicros() const { return field<int64_t>(offsetof(SessionRecordHeader, epochMicros)); }
+    ColumnSpan<uint32_t> handIds() const { return field<uint32_t>(offsetof(SessionRecordHeader, handId)); }
+    ColumnSpan<int32_t> handTypes() const { return field<int32_t>(offsetof(SessionRecordHeader, handType)); }
+    ColumnSpan<float> values(size_t column) const { return field<float>(columnTable[column].offset); }
+
+private:
+    const char* data;
+    size_t size;
+    const SessionFileHeader* fileHeader;
+    std::vector<SessionFileColumn> columnTable;
+    size_t records;
+    std::string lastError;
+
+    bool fail(const std::string& message);
+    template <typename T>
+    ColumnSpan<T> field(size_t offset) const {
+        return ColumnSpan<T>(data + fileHeader->headerBytes + offset, fileHeader->recordBytes, records);
+    }
+};
+
+#endif /* SessionFile_hpp */
@@ -0,0 +1,255 @@
+//
+//  SessionJournal.cpp
+//  LeapTracker
+//
+#include "SessionJournal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t kCommitSlotOffset[2] = { 1024, 2048 };
+
+size_t alignedEntryBytes(size_t payload) {
+    return (sizeof(JournalEntryHeader) + payload + 7) / 8 * 8;
+}
+
+uint32_t commitCrc(const JournalCommit& commit) {
+    return SessionJournal::crc32(reinterpret_cast<const char*>(&commit), offsetof(JournalCommit, crc));
+}
+
+}  // namespace
+
+SessionJournal::SessionJournal()
+    : mapping(nullptr), mappingBytes(0), ring(nullptr), ringBytes(0), position(0), sequence(0), appended(0), committed(0) {}
+
+SessionJournal::~SessionJournal() {
+    close(false);
+}
+
+bool SessionJournal::open(const std::string& journalPath, size_t bytes) {
+    close(false);
+    bytes = std::max(kMinimumBytes, (bytes + 7) / 8 * 8);
+    int fd = ::open(journalPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create journal " << journalPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    // Reserve the blocks now, so a full disk fails here and not as SIGBUS mid-session
+    size_t total = kPageBytes + bytes;
+    int error = posix_fallocate(fd, 0, static_cast<off_t>(total));
+    if (error != 0) {
+        std::cerr << "Failed to allocate journal " << journalPath << ": " << strerror(error) << std::endl;
+        ::close(fd);
+        unlink(journalPath.c_str());
+        return false;
+    }
+    void* address = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "Failed to map journal " << journalPath << ": " << strerror(errno) << std::endl;
+        unlink(journalPath.c_str());
+        return false;
+    }
+
+    path = journalPath;
+    mapping = static_cast<char*>(address);
+    mappingBytes = total;
+    ring = mapping + kPageBytes;
+    ringBytes = bytes;
+    position = 0;
+    sequence = 0;
+    appended = 0;
+    committed = 0;
+
+    JournalHeader header = { SESSION_JOURNAL_MAGIC, SESSION_JOURNAL_VERSION, kPageBytes, bytes, 0 };
+    memcpy(mapping, &header, sizeof(header));
+    return true;
+}
+
+void SessionJournal::append(const char* data, size_t size, uint64_t streamOffset) {
+    size_t entryBytes = alignedEntryBytes(size);
+    if (!ring || entryBytes > ringBytes / 2) {
+        return;
+    }
+    if (ringBytes - position < entryBytes) {
+        // Mark the tail unused if a header fits there; otherwise readers wrap on their own
+        if (ringBytes - position >= sizeof(JournalEntryHeader)) {
+            uint32_t wrap = SESSION_JOURNAL_WRAP_MAGIC;
+            memcpy(ring + position, &wrap, sizeof(wrap));
+        }
+        position = 0;
+    }
+
+    JournalEntryHeader entry = { SESSION_JOURNAL_ENTRY_MAGIC, static_cast<uint32_t>(size), streamOffset, crc32(data, size), 0 };
+    memcpy(ring + position + sizeof(entry), data, size);
+    memcpy(ring + position, &entry, sizeof(entry));
+    position += entryBytes;
+    if (position + sizeof(JournalEntryHeader) > ringBytes) {
+        position = 0;
+    }
+    appended = streamOffset + size;
+    reinterpret_cast<JournalHeader*>(mapping)->appendedBytes = appended;
+}
+
+void SessionJournal::commit(const std::string& partPath, uint64_t partBytes, uint64_t streamOffset, uint64_t ringPosition,
+                            bool compressed) {
+    if (!mapping) {
+        return;
+    }
+    JournalCommit record;
+    memset(&record, 0, sizeof(record));
+    record.sequence = ++sequence;
+    record.streamOffset = streamOffset;
+    record.ringPosition = ringPosition;
+    record.partBytes = partBytes;
+    record.compressed = compressed ? 1 : 0;
+    record.pathLength = static_cast<uint32_t>(std::min(partPath.size(), sizeof(record.partPath)));
+    memcpy(record.partPath, partPath.data(), record.pathLength);
+    record.crc = commitCrc(record);
+    // Alternate slots, so a commit torn by a crash leaves the previous one intact
+    memcpy(mapping + kCommitSlotOffset[sequence % 2], &record, sizeof(record));
+    committed.store(streamOffset, std::memory_order_relaxed);
+}
+
+bool SessionJournal::sync() {
+    if (!mapping) {
+        return false;
+    }
+    if (msync(mapping, mappingBytes, MS_SYNC) != 0) {
+        std::cerr << "Failed to sync journal " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SessionJournal::close(bool remove) {
+    if (!mapping) {
+        return;
+    }
+    munmap(mapping, mappingBytes);
+    mapping = nullptr;
+    ring = nullptr;
+    if (remove) {
+        unlink(path.c_str());
+    }
+}
+
+bool SessionJournal::recover(const std::string& journalPath, Recovery& recovery, std::string& error) {
+    int fd = ::open(journalPath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        error = "Cannot open " + journalPath + ": " + strerror(errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    if (size < kPageBytes) {
+        ::close(fd);
+        error = "Not a session journal (too short): " + journalPath;
+        return false;
+    }
+    void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        error = "Cannot map " + journalPath + ": " + strerror(errno);
+        return false;
+    }
+    const char* data = static_cast<const char*>(address);
+    struct Unmap {
+        const char* data;
+        size_t size;
+        ~Unmap() { munmap(const_cast<char*>(data), size); }
+    } unmap = { data, size };
+
+    JournalHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != SESSION_JOURNAL_MAGIC || header.version != SESSION_JOURNAL_VERSION ||
+        header.ringOffset < kPageBytes || header.ringOffset + header.ringBytes > size) {
+        error = "Not a session journal: " + journalPath;
+        return false;
+    }
+
+    // The newer of the two commit slots whose checksum holds
+    bool found = false;
+    for (size_t slot = 0; slot < 2; slot++) {
+        JournalCommit candidate;
+        memcpy(&candidate, data + kCommitSlotOffset[slot], sizeof(candidate));
+        if (candidate.sequence == 0 || candidate.crc != commitCrc(candidate) || candidate.pathLength > sizeof(candidate.partPath)) {
+            continue;
+        }
+        if (!found || candidate.sequence > recovery.commit.sequence) {
+            recovery.commit = candidate;
+            found = true;
+        }
+    }
+    if (!found || recovery.commit.ringPosition >= header.ringBytes) {
+        error = "Journal has no valid commit: " + journalPath;
+        return false;
+    }
+
+    // Follow the entries from the commit while they continue the stream
+    const char* ring = data + header.ringOffset;
+    uint64_t ringBytes = header.ringBytes;
+    uint64_t position = recovery.commit.ringPosition;
+    uint64_t expected = recovery.commit.streamOffset;
+    uint64_t walked = 0;
+    recovery.rows.clear();
+    while (walked < ringBytes) {
+        if (ringBytes - position < sizeof(JournalEntryHeader)) {
+            walked += ringBytes - position;
+            position = 0;
+            continue;
+        }
+        JournalEntryHeader entry;
+        memcpy(&entry, ring + position, sizeof(entry));
+        if (entry.magic == SESSION_JOURNAL_WRAP_MAGIC) {
+            walked += ringBytes - position;
+            position = 0;
+            continue;
+        }
+        size_t entryBytes = alignedEntryBytes(entry.size);
+        if (entry.magic != SESSION_JOURNAL_ENTRY_MAGIC || entry.streamOffset != expected || entryBytes > ringBytes - position ||
+            crc32(ring + position + sizeof(entry), entry.size) != entry.crc) {
+            break;
+        }
+        recovery.rows.append(ring + position + sizeof(entry), entry.size);
+        expected += entry.size;
+        position += entryBytes;
+        walked += entryBytes;
+    }
+    recovery.appendedBytes = std::max(header.appendedBytes, expected);
+    recovery.lostBytes = recovery.appendedBytes - expected;
+    return true;
+}
+
+uint32_t SessionJournal::crc32(const char* data, size_t size, uint32_t crc) {
+    // CRC-32 (IEEE), as zlib computes it
+    static const struct Table {
+        uint32_t values[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                values[i] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.values[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// end of SessionJournal.cpp //
@@ -0,0 +1,125 @@
+//
+//  SessionJournal.hpp
+//  LeapTracker
+//
+//  Crash journal for a session log (--journal-mb). Every append to an
+//  AsyncFileWriter is also copied into a preallocated, memory-mapped ring
+//  file next to the log, "<log>.journal", before it reaches the writer
+//  thread. A killed process loses nothing that was copied: the pages belong
+//  to the kernel's page cache, and msync at journalSyncInterval covers power
+//  loss and sleep. The writer thread commits how far the log file itself is
+//  complete (the part, its durable size, and where the following rows start
+//  in the ring), and LeapJournalRecover truncates the part to that size and
+//  appends the rows after it from the ring. A journal left behind after a
+//  session is the sign that it ended abruptly; a clean close deletes it.
+//
+//  Layout (little-endian, native structs):
+//    page 0: JournalHeader, then two JournalCommit slots written alternately
+//    ring:   entries { JournalEntryHeader, payload, padding to 8 bytes }
+//
+//  Recovery starts at the committed ring offset and reads only the rows the
+//  log is missing, so it takes the same time for a 64 MB or a 4 GB journal.
+//
+#ifndef SessionJournal_hpp
+#define SessionJournal_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Session journals are little-endian and are read and written in place"
+#endif
+
+#define SESSION_JOURNAL_MAGIC 0x524A544C        // "LTJR"
+#define SESSION_JOURNAL_ENTRY_MAGIC 0x454A544C  // "LTJE", an entry
+#define SESSION_JOURNAL_WRAP_MAGIC 0x574A544C   // "LTJW", the rest of the ring is unused
+#define SESSION_JOURNAL_VERSION 1
+
+struct JournalHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t ringOffset;            // of the ring in the file
+    uint64_t ringBytes;
+    uint64_t appendedBytes;         // stream bytes appended so far, stored after each entry
+};
+
+// The log file is complete up to streamOffset, which is partBytes into partPath
+struct JournalCommit {
+    uint64_t sequence;              // the newer valid slot wins
+    uint64_t streamOffset;          // rows appended before this point are in the log file
+    uint64_t ringPosition;          // where the entry at streamOffset starts
+    uint64_t partBytes;
+    uint32_t compressed;            // the part is zstd frames
+    uint32_t pathLength;
+    char partPath[968];
+    uint32_t crc;                   // of everything above
+    uint32_t reserved;
+};
+
+struct JournalEntryHeader {
+    uint32_t magic;
+    uint32_t size;                  // payload bytes
+    uint64_t streamOffset;          // of the payload's first byte
+    uint32_t crc;                   // of the payload
+    uint32_t reserved;
+};
+
+class SessionJournal {
+public:
+    static const size_t kPageBytes = 4096;
+    static const size_t kMinimumBytes = 1 << 20;
+
+    // What LeapJournalRecover needs from a journal
+    struct Recovery {
+        JournalCommit commit;
+        std::string rows;           // appended after the commit, in order
+        uint64_t appendedBytes;     // stream bytes the tracker had appended
+        uint64_t lostBytes;         // of those, overwritten or torn in the ring
+    };
+
+    SessionJournal();
+    ~SessionJournal();
+
+    SessionJournal(const SessionJournal&) = delete;
+    SessionJournal& operator=(const SessionJournal&) = delete;
+
+    // Creates and maps a journal of ringBytes plus a header page
+    bool open(const std::string& path, size_t ringBytes);
+    bool isOpen() const { return ring != nullptr; }
+
+    // Copies one append into the ring; streamOffset is its first byte in the log stream
+    void append(const char* data, size_t size, uint64_t streamOffset);
+    // Ring position of the next append
+    uint64_t head() const { return position; }
+
+    // Writer thread: the log is complete up to streamOffset
+    void commit(const std::string& partPath, uint64_t partBytes, uint64_t streamOffset, uint64_t ringPosition, bool compressed);
+    // Appended bytes the log file does not have yet; past ringBytes, the ring has overwritten some
+    uint64_t uncommittedBytes() const { return appended - committed.load(std::memory_order_relaxed); }
+    size_t capacity() const { return ringBytes; }
+
+    // msync the whole mapping
+    bool sync();
+    // Unmaps the journal; removes the file when the log is complete
+    void close(bool remove);
+
+    // Reads the last commit and every intact entry after it
+    static bool recover(const std::string& path, Recovery& recovery, std::string& error);
+
+    static uint32_t crc32(const char* data, size_t size, uint32_t crc = 0);
+
+private:
+    std::string path;
+    char* mapping;
+    size_t mappingBytes;
+    char* ring;
+    size_t ringBytes;
+    uint64_t position;
+    uint64_t sequence;
+    uint64_t appended;
+    std::atomic<uint64_t> committed;
+};
+
+#endif /* SessionJournal_hpp */
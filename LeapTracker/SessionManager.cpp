@@ -0,0 +1,145 @@
+//
+//  SessionManager.cpp
+//  LeapTracker
+//
+#include "SessionManager.hpp"
+#include <charconv>
+#include <iostream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+SessionManager::SessionManager(int sessionCount, int ioThreadCount)
+    : sessionCount(sessionCount), ioThreadCount(ioThreadCount)
+{
+    if (ioThreadCount < 1) {
+        throw std::invalid_argument("I/O thread count must be at least one");
+    }
+
+    oscSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (oscSocket == -1) {
+        throw std::runtime_error("Failed to create OSC socket");
+    }
+
+    wsServer.init_asio(&ioContext);
+    wsServer.set_reuse_addr(true);
+}
+
+SessionManager::~SessionManager() {
+    stop();
+    close(oscSocket);
+}
+
+void SessionManager::listen(int port, Handlers handlers) {
+    this->handlers = handlers;
+
+    // Refuse WebSocket upgrades for paths that name no session
+    wsServer.set_validate_handler([this](websocketpp::connection_hdl hdl) {
+        return sessionFor(hdl) >= 0;
+    });
+
+    wsServer.set_open_handler([this](websocketpp::connection_hdl hdl) {
+        int session = sessionFor(hdl);
+        if (session >= 0) {
+            this->handlers.open(session, hdl);
+        }
+    });
+
+    wsServer.set_close_handler([this](websocketpp::connection_hdl hdl) {
+        int session = sessionFor(hdl);
+        if (session >= 0) {
+            this->handlers.close(session, hdl);
+        }
+    });
+
+    wsServer.set_message_handler([this](websocketpp::connection_hdl hdl, WsServer::message_ptr msg) {
+        int session = sessionFor(hdl);
+        if (session >= 0) {
+            this->handlers.message(session, hdl, msg->get_payload());
+        }
+    });
+
+    // Plain HTTP requests on the same port serve session metrics
+    wsServer.set_http_handler([this](websocketpp::connection_hdl hdl) {
+        WsServer::connection_ptr con = wsServer.get_con_from_hdl(hdl);
+        int session;
+        std::string subpath;
+        if (route(con->get_resource(), session, subpath)) {
+            this->handlers.http(session, subpath, con);
+        } else {
+            con->set_status(websocketpp::http::status_code::not_found);
+            con->set_body("Not found\n");
+        }
+    });
+
+    wsServer.listen(port);
+    wsServer.start_accept();
+
+    for (int i = 0; i < ioThreadCount; i++) {
+        ioThreads.emplace_back([this]() {
+            try {
+                ioContext.run();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Error in WebSocket server: " << e.what() << std::endl;
+            }
+        });
+    }
+}
+
+void SessionManager::stop() {
+    if (ioThreads.empty()) {
+        return;
+    }
+    wsServer.stop_listening();
+    wsServer.stop();
+    for (auto& thread : ioThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    ioThreads.clear();
+}
+
+bool SessionManager::route(const std::string& resource, int& session, std::string& subpath) const {
+    std::string path = resource.substr(0, resource.find('?'));
+    const std::string prefix = "/session/";
+
+    if (path.compare(0, prefix.size(), prefix) != 0) {
+        session = 0;
+        subpath = path == "/" ? "" : path;
+        return true;
+    }
+
+    size_t idStart = prefix.size();
+    size_t idEnd = path.find('/', idStart);
+    std::string id = path.substr(idStart, idEnd == std::string::npos ? std::string::npos : idEnd - idStart);
+    // A handful of digits at most, so the id cannot overflow
+    if (id.empty() || id.size() > 4 || id.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    int index = 0;
+    std::from_chars_result parsed = std::from_chars(id.data(), id.data() + id.size(), index);
+    if (parsed.ec != std::errc() || index < 0 || index >= sessionCount) {
+        return false;
+    }
+    session = index;
+    subpath = idEnd == std::string::npos ? "" : path.substr(idEnd);
+    return true;
+}
+
+int SessionManager::sessionFor(websocketpp::connection_hdl hdl) {
+    WsServer::connection_ptr con = wsServer.get_con_from_hdl(hdl);
+    int session;
+    std::string subpath;
+    if (!route(con->get_resource(), session, subpath) || !subpath.empty()) {
+        return -1;
+    }
+    return session;
+}
+
+void SessionManager::sendOsc(const struct sockaddr_in& destination, const char* data, size_t size) {
+    sendto(oscSocket, data, size, 0, (const struct sockaddr*)&destination, sizeof(destination));
+}
+
+// end of SessionManager.cpp //
@@ -0,0 +1,62 @@
+//
+//  SessionManager.hpp
+//  LeapTracker
+//
+//  Transport shared by every tracking session in the process: one asio
+//  io_context served by a small thread pool, one WebSocket/HTTP listener whose
+//  connections are routed to a session by request path, and one UDP socket
+//  for OSC. Sessions only keep their own connection sets and OSC destination.
+//
+//  Paths: "/session/<id>" selects a session and "/session/<id>/metrics" its
+//  metrics; "/" and "/metrics" are session 0, as with a single session.
+//
+#ifndef SessionManager_hpp
+#define SessionManager_hpp
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netinet/in.h>
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+
+using WsServer = websocketpp::server<websocketpp::config::asio>;
+
+class SessionManager {
+public:
+    // Called on io threads with the session the request path resolved to
+    struct Handlers {
+        std::function<void(int session, websocketpp::connection_hdl hdl)> open;
+        std::function<void(int session, websocketpp::connection_hdl hdl)> close;
+        std::function<void(int session, websocketpp::connection_hdl hdl, const std::string& payload)> message;
+        // subpath is what follows the session prefix, e.g. "/metrics"
+        std::function<void(int session, const std::string& subpath, WsServer::connection_ptr con)> http;
+    };
+
+    SessionManager(int sessionCount, int ioThreadCount);
+    ~SessionManager();
+
+    void listen(int port, Handlers handlers);
+    void stop();
+
+    // Resolves a request path to a session; false if it names no session
+    bool route(const std::string& resource, int& session, std::string& subpath) const;
+
+    WsServer& server() { return wsServer; }
+    void sendOsc(const struct sockaddr_in& destination, const char* data, size_t size);
+
+private:
+    int sessionCount;
+    int ioThreadCount;
+    websocketpp::lib::asio::io_service ioContext;
+    WsServer wsServer;
+    std::vector<std::thread> ioThreads;
+    Handlers handlers;
+    int oscSocket;
+
+    int sessionFor(websocketpp::connection_hdl hdl);
+};
+
+#endif /* SessionManager_hpp */
@@ -0,0 +1,110 @@
+//
+//  SessionStatistics.cpp
+//  LeapTracker
+//
+#include "SessionStatistics.hpp"
+#include <algorithm>
+#include <cmath>
+
+void RunningStats::add(double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+    if (count == 0) {
+        min = max = value;
+    } else {
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    count++;
+    double delta = value - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (value - mean);
+    sketch.add(value);
+}
+
+// Chan et al.'s pairwise update of mean and squared deviations
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    double n = static_cast<double>(count);
+    double m = static_cast<double>(other.count);
+    double delta = other.mean - mean;
+    mean += delta * m / (n + m);
+    m2 += other.m2 + delta * delta * n * m / (n + m);
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    count += other.count;
+    sketch.merge(other.sketch);
+}
+
+nlohmann::json RunningStats::toJson() const {
+    if (count == 0) {
+        return {{"count", 0}};
+    }
+    return {
+        {"count", count},
+        {"min", min},
+        {"max", max},
+        {"range", max - min},
+        {"mean", mean},
+        {"stddev", std::sqrt(variance())},
+        {"p5", sketch.quantile(0.05)},
+        {"p25", sketch.quantile(0.25)},
+        {"p50", sketch.quantile(0.50)},
+        {"p75", sketch.quantile(0.75)},
+        {"p95", sketch.quantile(0.95)}
+    };
+}
+
+SessionStatistics::SessionStatistics(const ExercisePipeline& pipeline, bool abduction) : frames() {
+    for (int c = 0; c < HandChannels::Metrics; c++) {
+        channels.push_back(c);
+        names.push_back(HandChannels::columnName(c));
+    }
+    for (size_t m = 0; m < pipeline.metricCount; m++) {
+        channels.push_back(HandChannels::Metrics + static_cast<int>(m));
+        names.push_back(metricInfo(pipeline.metrics[m]).csvColumn);
+    }
+    if (abduction) {
+        for (int c = HandChannels::Abduction; c < HandChannels::Count; c++) {
+            channels.push_back(c);
+            names.push_back(HandChannels::columnName(c));
+        }
+    }
+    for (auto& handStats : stats) {
+        handStats.resize(channels.size());
+    }
+}
+
+void SessionStatistics::update(eLeapHandType hand, const HandChannels& values) {
+    int h = handSlot(hand);
+    std::lock_guard<std::mutex> lock(mutex);
+    frames[h]++;
+    for (size_t i = 0; i < channels.size(); i++) {
+        stats[h][i].add(values[channels[i]]);
+    }
+}
+
+nlohmann::json SessionStatistics::toJson() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    nlohmann::json report = nlohmann::json::object();
+    for (int h = 0; h < kHandSlots; h++) {
+        nlohmann::json hand = nlohmann::json::object();
+        for (size_t i = 0; i < channels.size(); i++) {
+            hand[names[i]] = stats[h][i].toJson();
+        }
+        report[handSlotName(h)] = {
+            {"frames", frames[h]},
+            {"channels", hand}
+        };
+    }
+    return report;
+}
+
+// end of SessionStatistics.cpp //
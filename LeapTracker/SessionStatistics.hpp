@@ -0,0 +1,63 @@
+//
+//  SessionStatistics.hpp
+//  LeapTracker
+//
+//  Running aggregates of every output channel of a session, per hand:
+//  min/max, Welford mean and variance, and a quantile sketch, each updated
+//  in O(1) per frame from the unfiltered values the CSV records. Served live
+//  over the WebSocket ({"command": "stats"}) and /stats, and written next to
+//  the CSV as <log file>_summary.json when tracking stops, so range of
+//  motion and percentiles are available without re-reading the CSV.
+//
+#ifndef SessionStatistics_hpp
+#define SessionStatistics_hpp
+
+#include "LeapC.h"
+#include "HandChannels.hpp"
+#include "QuantileSketch.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Aggregates of one channel; NaN values are skipped. merge() combines two
+// channels' aggregates exactly (the sketch within its relative accuracy).
+struct RunningStats {
+    uint64_t count = 0;
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    double m2 = 0;              // sum of squared deviations from the mean
+    QuantileSketch sketch;
+
+    void add(double value);
+    void merge(const RunningStats& other);
+    // Sample variance; 0 with fewer than two values
+    double variance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+
+    nlohmann::json toJson() const;
+};
+
+class SessionStatistics {
+public:
+    // Tracks the channels the session outputs: the pipeline's metrics, and
+    // abduction only when joint angles come from bone rotations
+    SessionStatistics(const ExercisePipeline& pipeline, bool abduction);
+
+    // Processing thread, once per hand per frame
+    void update(eLeapHandType hand, const HandChannels& channels);
+
+    // Any thread: {"left": {"frames": n, "channels": {<CSV column>: {...}}}, "right": ...}
+    nlohmann::json toJson() const;
+
+private:
+    std::vector<int> channels;
+    std::vector<std::string> names;
+    // Indexed by handSlot()
+    std::vector<RunningStats> stats[kHandSlots];
+    uint64_t frames[kHandSlots];
+    mutable std::mutex mutex;
+};
+
+#endif /* SessionStatistics_hpp */
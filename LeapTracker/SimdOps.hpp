@@ -0,0 +1,154 @@
+//
+//  SimdOps.hpp
+//  LeapTracker
+//
+//  The few vector operations the hand kernel and channel filter need, for
+//  whichever instruction set the including file is built with: AVX2 or SSE2
+//  on x86-64, NEON on arm64, single floats elsewhere. Separate multiplies
+//  and adds (no FMA) keep the results identical across paths.
+//
+//  Everything is in an unnamed namespace, so files built with different
+//  instruction sets each get their own copy. Only include this from .cpp files.
+//
+#ifndef SimdOps_hpp
+#define SimdOps_hpp
+
+#include "FastMath.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEAPTRACKER_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LEAPTRACKER_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LEAPTRACKER_SIMD_NEON 1
+#endif
+
+namespace {
+
+#if LEAPTRACKER_SIMD_AVX2
+typedef __m256 vfloat;
+const int kWidth = 8;
+inline vfloat vload(const float* p) { return _mm256_load_ps(p); }
+inline void vstore(float* p, vfloat a) { _mm256_store_ps(p, a); }
+inline vfloat vloadu(const float* p) { return _mm256_loadu_ps(p); }
+inline void vstoreu(float* p, vfloat a) { _mm256_storeu_ps(p, a); }
+inline vfloat vset(float a) { return _mm256_set1_ps(a); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+inline vfloat vsqrt(vfloat a) { return _mm256_sqrt_ps(a); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+inline vfloat vabs(vfloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+// |magnitude| with the sign of sign
+inline vfloat vcopysign(vfloat magnitude, vfloat sign) {
+    __m256 signBit = _mm256_set1_ps(-0.0f);
+    return _mm256_or_ps(_mm256_andnot_ps(signBit, magnitude), _mm256_and_ps(signBit, sign));
+}
+typedef __m256 vmask;
+inline vmask vgreater(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline vmask vnotnan(vfloat a) { return _mm256_cmp_ps(a, a, _CMP_ORD_Q); }
+inline vfloat vselect(vmask mask, vfloat ifTrue, vfloat ifFalse) { return _mm256_blendv_ps(ifFalse, ifTrue, mask); }
+#elif LEAPTRACKER_SIMD_SSE2
+typedef __m128 vfloat;
+const int kWidth = 4;
+inline vfloat vload(const float* p) { return _mm_load_ps(p); }
+inline void vstore(float* p, vfloat a) { _mm_store_ps(p, a); }
+inline vfloat vloadu(const float* p) { return _mm_loadu_ps(p); }
+inline void vstoreu(float* p, vfloat a) { _mm_storeu_ps(p, a); }
+inline vfloat vset(float a) { return _mm_set1_ps(a); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+inline vfloat vsqrt(vfloat a) { return _mm_sqrt_ps(a); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+inline vfloat vabs(vfloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline vfloat vcopysign(vfloat magnitude, vfloat sign) {
+    __m128 signBit = _mm_set1_ps(-0.0f);
+    return _mm_or_ps(_mm_andnot_ps(signBit, magnitude), _mm_and_ps(signBit, sign));
+}
+typedef __m128 vmask;
+inline vmask vgreater(vfloat a, vfloat b) { return _mm_cmpgt_ps(a, b); }
+inline vmask vnotnan(vfloat a) { return _mm_cmpord_ps(a, a); }
+inline vfloat vselect(vmask mask, vfloat ifTrue, vfloat ifFalse) {
+    return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+#elif LEAPTRACKER_SIMD_NEON
+typedef float32x4_t vfloat;
+const int kWidth = 4;
+inline vfloat vload(const float* p) { return vld1q_f32(p); }
+inline void vstore(float* p, vfloat a) { vst1q_f32(p, a); }
+inline vfloat vloadu(const float* p) { return vld1q_f32(p); }
+inline void vstoreu(float* p, vfloat a) { vst1q_f32(p, a); }
+inline vfloat vset(float a) { return vdupq_n_f32(a); }
+inline vfloat vadd(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return vdivq_f32(a, b); }
+inline vfloat vsqrt(vfloat a) { return vsqrtq_f32(a); }
+inline vfloat vmin(vfloat a, vfloat b) { return vminq_f32(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return vmaxq_f32(a, b); }
+inline vfloat vabs(vfloat a) { return vabsq_f32(a); }
+inline vfloat vcopysign(vfloat magnitude, vfloat sign) {
+    return vbslq_f32(vdupq_n_u32(0x80000000u), sign, vabsq_f32(magnitude));
+}
+typedef uint32x4_t vmask;
+inline vmask vgreater(vfloat a, vfloat b) { return vcgtq_f32(a, b); }
+inline vmask vnotnan(vfloat a) { return vceqq_f32(a, a); }
+inline vfloat vselect(vmask mask, vfloat ifTrue, vfloat ifFalse) { return vbslq_f32(mask, ifTrue, ifFalse); }
+#else
+typedef float vfloat;
+const int kWidth = 1;
+inline vfloat vload(const float* p) { return *p; }
+inline void vstore(float* p, vfloat a) { *p = a; }
+inline vfloat vloadu(const float* p) { return *p; }
+inline void vstoreu(float* p, vfloat a) { *p = a; }
+inline vfloat vset(float a) { return a; }
+inline vfloat vadd(vfloat a, vfloat b) { return a + b; }
+inline vfloat vsub(vfloat a, vfloat b) { return a - b; }
+inline vfloat vmul(vfloat a, vfloat b) { return a * b; }
+inline vfloat vdiv(vfloat a, vfloat b) { return a / b; }
+inline vfloat vsqrt(vfloat a) { return std::sqrt(a); }
+inline vfloat vmin(vfloat a, vfloat b) { return std::min(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return std::max(a, b); }
+inline vfloat vabs(vfloat a) { return std::fabs(a); }
+inline vfloat vcopysign(vfloat magnitude, vfloat sign) { return std::copysign(magnitude, sign); }
+typedef bool vmask;
+inline vmask vgreater(vfloat a, vfloat b) { return a > b; }
+inline vmask vnotnan(vfloat a) { return a == a; }
+inline vfloat vselect(vmask mask, vfloat ifTrue, vfloat ifFalse) { return mask ? ifTrue : ifFalse; }
+#endif
+
+inline vfloat vdot(vfloat ax, vfloat ay, vfloat az, vfloat bx, vfloat by, vfloat bz) {
+    return vadd(vadd(vmul(ax, bx), vmul(ay, by)), vmul(az, bz));
+}
+
+// fastmath::atan2 across lanes, in radians
+inline vfloat vatan2(vfloat y, vfloat x) {
+    const vfloat zero = vset(0.0f), halfPi = vset(fastmath::kHalfPi), pi = vset(fastmath::kPi);
+    vfloat ax = vabs(x), ay = vabs(y);
+    vmask steep = vgreater(ay, ax);
+    vfloat largest = vmax(vmax(ax, ay), vset(1e-30f));
+    vfloat t = vdiv(vmin(ax, ay), largest);
+    vfloat t2 = vmul(t, t);
+    vfloat poly = vadd(vset(fastmath::kAtan7), vmul(t2, vset(fastmath::kAtan9)));
+    poly = vadd(vset(fastmath::kAtan5), vmul(t2, poly));
+    poly = vadd(vset(fastmath::kAtan3), vmul(t2, poly));
+    poly = vadd(vset(fastmath::kAtan1), vmul(t2, poly));
+    vfloat r = vmul(t, poly);
+    r = vselect(steep, vsub(halfPi, r), r);
+    r = vselect(vgreater(zero, x), vsub(pi, r), r);
+    return vcopysign(r, y);
+}
+
+}  // namespace
+
+#endif /* SimdOps_hpp */
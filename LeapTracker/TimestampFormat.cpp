@@ -0,0 +1,101 @@
+//
+//  TimestampFormat.cpp
+//  LeapTracker
+//
+#include "TimestampFormat.hpp"
+#include <ctime>
+#include <stdexcept>
+
+namespace {
+
+// Days since 1970-01-01 to a proleptic Gregorian date (Howard Hinnant's civil_from_days)
+void civilFromDays(int64_t days, int& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int>(yoe + era * 400) + (month <= 2);
+}
+
+char* writeDigits(char* out, unsigned value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+}  // namespace
+
+int64_t localUtcOffsetSeconds(int64_t epochMicros) {
+    std::time_t seconds = static_cast<std::time_t>(epochMicros / 1000000);
+    std::tm local;
+    return localtime_r(&seconds, &local) ? local.tm_gmtoff : 0;
+}
+
+size_t formatTimestamp(int64_t epochMicros, TimestampFormat format, int64_t utcOffsetSeconds, char* buffer) {
+    char* out = buffer;
+
+    if (format == TimestampFormat::EpochMicros) {
+        uint64_t value = epochMicros < 0 ? 0 - static_cast<uint64_t>(epochMicros) : static_cast<uint64_t>(epochMicros);
+        char digits[20];
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        if (epochMicros < 0) {
+            *out++ = '-';
+        }
+        while (count) {
+            *out++ = digits[--count];
+        }
+        return out - buffer;
+    }
+
+    int64_t localMicros = epochMicros + utcOffsetSeconds * 1000000;
+    int64_t totalSeconds = floorDiv(localMicros, 1000000);
+    unsigned micros = static_cast<unsigned>(localMicros - totalSeconds * 1000000);
+    int64_t days = floorDiv(totalSeconds, 86400);
+    unsigned secondOfDay = static_cast<unsigned>(totalSeconds - days * 86400);
+
+    int year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    out = writeDigits(out, static_cast<unsigned>(year), 4);
+    *out++ = '-';
+    out = writeDigits(out, month, 2);
+    *out++ = '-';
+    out = writeDigits(out, day, 2);
+    *out++ = ' ';
+    out = writeDigits(out, secondOfDay / 3600, 2);
+    *out++ = ':';
+    out = writeDigits(out, (secondOfDay / 60) % 60, 2);
+    *out++ = ':';
+    out = writeDigits(out, secondOfDay % 60, 2);
+    *out++ = '.';
+    out = writeDigits(out, micros, 6);
+    return out - buffer;
+}
+
+TimestampFormat parseTimestampFormat(const std::string& name) {
+    if (name == "local") {
+        return TimestampFormat::LocalMicros;
+    }
+    if (name == "epoch") {
+        return TimestampFormat::EpochMicros;
+    }
+    throw std::invalid_argument("Unknown timestamp format: " + name);
+}
+
+// end of TimestampFormat.cpp //
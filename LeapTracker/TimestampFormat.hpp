@@ -0,0 +1,33 @@
+//
+//  TimestampFormat.hpp
+//  LeapTracker
+//
+//  Text of the session log timestamps. Kept apart from DeviceClock, which
+//  needs LeapC, so offline tools such as LeapSessionToCsv build without the
+//  Ultraleap SDK. Formatting writes straight into a caller-supplied buffer
+//  and never allocates.
+//
+#ifndef TimestampFormat_hpp
+#define TimestampFormat_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Large enough for "YYYY-MM-DD HH:MM:SS.uuuuuu" or a signed 64-bit integer
+#define DEVICE_CLOCK_TIMESTAMP_SIZE 32
+
+enum class TimestampFormat {
+    LocalMicros,  // "2024-07-29 19:38:43.123456" in local time
+    EpochMicros   // microseconds since the Unix epoch
+};
+
+// Writes the timestamp for a local time zone offset into buffer (at least
+// DEVICE_CLOCK_TIMESTAMP_SIZE bytes, not null-terminated) and returns the
+// number of characters written
+size_t formatTimestamp(int64_t epochMicros, TimestampFormat format, int64_t utcOffsetSeconds, char* buffer);
+// This machine's local time zone offset at the given time
+int64_t localUtcOffsetSeconds(int64_t epochMicros);
+TimestampFormat parseTimestampFormat(const std::string& name);
+
+#endif /* TimestampFormat_hpp */
@@ -0,0 +1,96 @@
+//
+//  TrackerMetrics.cpp
+//  LeapTracker
+//
+#include "TrackerMetrics.hpp"
+#include <iomanip>
+#include <sstream>
+
+TrackerMetrics::TrackerMetrics() : framesProcessed(0) {
+    for (auto& count : dropped) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* TrackerMetrics::stageName(Stage stage) {
+    switch (stage) {
+        case CaptureToPoll: return "captureToPoll";
+        case Queue: return "queue";
+        case Compute: return "compute";
+        case Filter: return "filter";
+        case Serialize: return "serialize";
+        case Send: return "send";
+        case EndToEnd: return "endToEnd";
+        default: return "unknown";
+    }
+}
+
+void TrackerMetrics::recordDroppedFrame(eLeapDroppedFrameType type) {
+    int index = type <= eLeapDroppedFrameType_Other ? type : eLeapDroppedFrameType_Other;
+    dropped[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t TrackerMetrics::droppedFrames(eLeapDroppedFrameType type) const {
+    return dropped[type].load(std::memory_order_relaxed);
+}
+
+nlohmann::json TrackerMetrics::toJson() const {
+    nlohmann::json latency;
+    for (int i = 0; i < StageCount; i++) {
+        const LatencyHistogram& h = histograms[i];
+        latency[stageName(static_cast<Stage>(i))] = {
+            {"count", h.count()},
+            {"meanMicros", h.mean() / 1000.0},
+            {"p50Micros", h.percentile(0.50) / 1000.0},
+            {"p99Micros", h.percentile(0.99) / 1000.0},
+            {"p999Micros", h.percentile(0.999) / 1000.0},
+            {"maxMicros", h.max() / 1000.0}
+        };
+    }
+
+    return {
+        {"framesProcessed", frames()},
+        {"droppedFrames", {
+            {"preprocessingQueue", droppedFrames(eLeapDroppedFrameType_PreprocessingQueue)},
+            {"trackingQueue", droppedFrames(eLeapDroppedFrameType_TrackingQueue)},
+            {"other", droppedFrames(eLeapDroppedFrameType_Other)}
+        }},
+        {"latency", latency}
+    };
+}
+
+std::string TrackerMetrics::summary() const {
+    std::stringstream ss;
+    ss << "Frames processed: " << frames() << ", dropped by service: "
+       << droppedFrames(eLeapDroppedFrameType_PreprocessingQueue) << " preprocessing / "
+       << droppedFrames(eLeapDroppedFrameType_TrackingQueue) << " tracking / "
+       << droppedFrames(eLeapDroppedFrameType_Other) << " other\n";
+    ss << std::fixed << std::setprecision(1);
+    for (int i = 0; i < StageCount; i++) {
+        const LatencyHistogram& h = histograms[i];
+        ss << "  " << std::left << std::setw(14) << stageName(static_cast<Stage>(i)) << std::right
+           << " p50 " << std::setw(8) << h.percentile(0.50) / 1000.0
+           << " us  p99 " << std::setw(8) << h.percentile(0.99) / 1000.0
+           << " us  p99.9 " << std::setw(8) << h.percentile(0.999) / 1000.0 << " us\n";
+    }
+    return ss.str();
+}
+
+StageTimer::StageTimer(TrackerMetrics& metrics) : metrics(metrics), last(Clock::now()), totals(), lapped(0) {}
+
+void StageTimer::lap(TrackerMetrics::Stage stage) {
+    Clock::time_point now = Clock::now();
+    totals[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+    lapped |= 1u << stage;
+    last = now;
+}
+
+void StageTimer::finish() {
+    for (int i = 0; i < TrackerMetrics::StageCount; i++) {
+        if (lapped & (1u << i)) {
+            metrics.record(static_cast<TrackerMetrics::Stage>(i), totals[i]);
+        }
+    }
+}
+
+// end of TrackerMetrics.cpp //
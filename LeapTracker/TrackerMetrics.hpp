@@ -0,0 +1,72 @@
+//
+//  TrackerMetrics.hpp
+//  LeapTracker
+//
+//  Per-stage latency histograms and dropped-frame counters for the tracking
+//  pipeline, served as JSON from the WebSocket port's /metrics endpoint.
+//
+#ifndef TrackerMetrics_hpp
+#define TrackerMetrics_hpp
+
+#include "LeapC.h"
+#include "LatencyHistogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+class TrackerMetrics {
+public:
+    enum Stage {
+        CaptureToPoll,  // device capture to LeapPollConnection returning the frame
+        Queue,          // time spent in the frame ring
+        Compute,        // distances, joint angles, exercise metrics and session statistics
+        Filter,         // smoothing of the live output channels
+        Serialize,      // CSV row and JSON building
+        Send,           // CSV write, OSC and WebSocket output
+        EndToEnd,       // device capture to the last output of the frame
+        StageCount
+    };
+
+    TrackerMetrics();
+
+    static const char* stageName(Stage stage);
+
+    void record(Stage stage, uint64_t nanoseconds) { histograms[stage].record(nanoseconds); }
+    const LatencyHistogram& histogram(Stage stage) const { return histograms[stage]; }
+
+    void recordDroppedFrame(eLeapDroppedFrameType type);
+    uint64_t droppedFrames(eLeapDroppedFrameType type) const;
+
+    void countFrame() { framesProcessed.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t frames() const { return framesProcessed.load(std::memory_order_relaxed); }
+
+    nlohmann::json toJson() const;
+    std::string summary() const;
+
+private:
+    LatencyHistogram histograms[StageCount];
+    std::atomic<uint64_t> dropped[3];
+    std::atomic<uint64_t> framesProcessed;
+};
+
+// Attributes wall time between successive laps to pipeline stages and records
+// each stage's total once per frame.
+class StageTimer {
+public:
+    explicit StageTimer(TrackerMetrics& metrics);
+
+    void lap(TrackerMetrics::Stage stage);
+    void finish();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    TrackerMetrics& metrics;
+    Clock::time_point last;
+    uint64_t totals[TrackerMetrics::StageCount];
+    uint32_t lapped;
+};
+
+#endif /* TrackerMetrics_hpp */
@@ -0,0 +1,122 @@
+//
+//  FastMathBenchmark.cpp
+//  LeapTracker
+//
+//  Checks the FastTrig approximations against libm over their whole domain
+//  and compares the throughput of the two policies. Exits with status 1 if
+//  any function exceeds the error bound documented in FastMath.hpp.
+//
+//  Usage: FastMathBenchmark [iterations]
+//
+#include "FastMath.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const double kRadToDeg = 180.0 / 3.14159265358979323846;
+const int kSamples = 4096;
+
+struct ErrorCheck {
+    const char* name;
+    double maxErrorDegrees;
+    double worstArgument;
+    double bound;
+
+    bool report() const {
+        bool ok = maxErrorDegrees <= bound;
+        std::cout << "  " << name << ": max error " << maxErrorDegrees << " deg at " << worstArgument
+                  << " (bound " << bound << ") " << (ok ? "ok" : "FAILED") << std::endl;
+        return ok;
+    }
+};
+
+template <typename Approx, typename Reference>
+ErrorCheck checkUnary(const char* name, double bound, Approx approx, Reference reference) {
+    ErrorCheck check = { name, 0.0, 0.0, bound };
+    // Every float in [-1, 1] would take too long; a fine grid plus both ends
+    const int steps = 1 << 22;
+    for (int i = 0; i <= steps; i++) {
+        float x = -1.0f + 2.0f * static_cast<float>(i) / steps;
+        double error = std::fabs(approx(x) - reference(static_cast<double>(x))) * kRadToDeg;
+        if (error > check.maxErrorDegrees) {
+            check.maxErrorDegrees = error;
+            check.worstArgument = x;
+        }
+    }
+    return check;
+}
+
+ErrorCheck checkAtan2() {
+    ErrorCheck check = { "atan2", 0.0, 0.0, fastmath::kAtan2MaxErrorDegrees };
+    const int steps = 1 << 20;
+    const float radii[] = { 1e-3f, 1.0f, 250.0f };
+    for (float radius : radii) {
+        for (int i = 0; i < steps; i++) {
+            double theta = -3.14159265358979323846 + 2.0 * 3.14159265358979323846 * i / steps;
+            float y = static_cast<float>(radius * std::sin(theta));
+            float x = static_cast<float>(radius * std::cos(theta));
+            double reference = std::atan2(static_cast<double>(y), static_cast<double>(x));
+            double error = std::fabs(fastmath::atan2(y, x) - reference) * kRadToDeg;
+            // -pi and pi are the same angle
+            error = std::min(error, 360.0 - error);
+            if (error > check.maxErrorDegrees) {
+                check.maxErrorDegrees = error;
+                check.worstArgument = theta * kRadToDeg;
+            }
+        }
+    }
+    return check;
+}
+
+template <typename Policy>
+double nanosecondsPerCall(const std::vector<float>& unit, const std::vector<float>& xs, int iterations, float& checksum) {
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (size_t i = 0; i < unit.size(); i++) {
+            checksum += Policy::acos(unit[i]) + Policy::asin(unit[i]) + Policy::atan2(unit[i], xs[i]);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (3.0 * iterations * unit.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+    std::cout << "Accuracy against libm (double precision):" << std::endl;
+    bool ok = true;
+    ok &= checkUnary("acos", fastmath::kAcosMaxErrorDegrees,
+                     [](float x) { return static_cast<double>(fastmath::acos(x)); },
+                     [](double x) { return std::acos(x); }).report();
+    ok &= checkUnary("asin", fastmath::kAsinMaxErrorDegrees,
+                     [](float x) { return static_cast<double>(fastmath::asin(x)); },
+                     [](double x) { return std::asin(x); }).report();
+    ok &= checkAtan2().report();
+
+    // Arguments shaped like the tracker's: cosines and unit vector components
+    std::vector<float> unit(kSamples), xs(kSamples);
+    srand(1);
+    for (int i = 0; i < kSamples; i++) {
+        unit[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        xs[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+    }
+
+    float checksum = 0;
+    double libmNs = nanosecondsPerCall<LibmTrig>(unit, xs, iterations, checksum);
+    double fastNs = nanosecondsPerCall<FastTrig>(unit, xs, iterations, checksum);
+    std::cout << "Throughput, " << kSamples << " arguments x " << iterations << " iterations:" << std::endl;
+    std::cout << "  " << LibmTrig::name() << ": " << libmNs << " ns/call" << std::endl;
+    std::cout << "  " << FastTrig::name() << ": " << fastNs << " ns/call (" << libmNs / fastNs << "x)" << std::endl;
+    std::cout << "  tracker policy: " << Trig::name() << ", checksum " << checksum << std::endl;
+
+    return ok ? 0 : 1;
+}
+
+// end of FastMathBenchmark.cpp //
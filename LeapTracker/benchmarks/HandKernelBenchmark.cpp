@@ -0,0 +1,130 @@
+//
+//  HandKernelBenchmark.cpp
+//  LeapTracker
+//
+//  Compares the vectorised hand kernel against the original scalar
+//  calculateAngle/calculateDistance calls on a set of synthetic hand poses.
+//  Both are checked against joint angles computed in double precision; the
+//  scalar path takes acos of a float cosine and is off by up to about 0.03
+//  degrees on nearly straight joints, so the kernel is held to a bound of
+//  its own (kMaxKernelErrorDegrees) and the run fails above it.
+//
+//  Usage: HandKernelBenchmark [iterations]
+//
+#include "FastMath.hpp"
+#include "HandKernel.hpp"
+#include "LeapCStandIn/SyntheticHand.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const int kPoses = 1024;
+
+// Largest kernel joint angle error allowed against the double-precision angles
+#if LEAPTRACKER_FAST_MATH
+const double kMaxKernelErrorDegrees = fastmath::kAtan2MaxErrorDegrees + 1e-4;
+#else
+const double kMaxKernelErrorDegrees = 1e-4;
+#endif
+
+// Angle at joint p2 between bones p1->p2 and p2->p3, in degrees, from doubles
+double referenceAngle(const LEAP_VECTOR& p1, const LEAP_VECTOR& p2, const LEAP_VECTOR& p3) {
+    double ax = double(p2.x) - p1.x, ay = double(p2.y) - p1.y, az = double(p2.z) - p1.z;
+    double bx = double(p3.x) - p2.x, by = double(p3.y) - p2.y, bz = double(p3.z) - p2.z;
+    double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+    return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz) * 180.0 / 3.14159265358979323846;
+}
+
+template <typename Kernel>
+double nanosecondsPerHand(const std::vector<LEAP_HAND>& hands, int iterations, Kernel kernel, float& checksum) {
+    HandGeometry angles;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (const LEAP_HAND& hand : hands) {
+            kernel(hand, angles);
+            // Consume the results so the calls cannot be optimised away
+            float sample = angles.jointAngles[it % 5][it % 3] + angles.thumbDistances[it % 4];
+            if (!std::isnan(sample)) {
+                checksum += sample;
+            }
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (double(iterations) * hands.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+    // A few seconds of both hands going through the synthetic exercises
+    std::vector<LEAP_HAND> hands(kPoses);
+    SyntheticHand right(eLeapHandType_Right, 1, 0.0);
+    SyntheticHand left(eLeapHandType_Left, 2, 0.7);
+    for (int i = 0; i < kPoses; i++) {
+        (i % 2 ? left : right).generate(i / 120.0, hands[i]);
+    }
+
+    // Accuracy: angles in degrees, distances in mm
+    double maxAngleError = 0;
+    double maxKernelError = 0;
+    double maxScalarError = 0;
+    double maxDistanceError = 0;
+    int scalarNaNs = 0;
+    for (const LEAP_HAND& hand : hands) {
+        HandGeometry scalar, simd;
+        computeHandGeometryScalar(hand, scalar);
+        computeHandGeometry(hand, simd);
+        for (int f = 0; f < 5; f++) {
+            const LEAP_DIGIT& finger = hand.digits[f];
+            for (int j = 0; j < 3; j++) {
+                // Joints next to the zero-length thumb metacarpal have no angle
+                if (simd.boneLengths[f][j] < 1e-4f || simd.boneLengths[f][j + 1] < 1e-4f) {
+                    continue;
+                }
+                const LEAP_VECTOR& p1 = finger.bones[j].prev_joint;
+                double reference = referenceAngle(p1, finger.bones[j].next_joint, finger.bones[j + 1].next_joint);
+                maxKernelError = std::max(maxKernelError, std::fabs(simd.jointAngles[f][j] - reference));
+                // The scalar path has no clamp and yields NaN for (anti)parallel bones
+                if (std::isnan(scalar.jointAngles[f][j])) {
+                    scalarNaNs++;
+                    continue;
+                }
+                maxScalarError = std::max(maxScalarError, std::fabs(scalar.jointAngles[f][j] - reference));
+                maxAngleError = std::max(maxAngleError, double(std::fabs(scalar.jointAngles[f][j] - simd.jointAngles[f][j])));
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            maxDistanceError = std::max(maxDistanceError, double(std::fabs(scalar.thumbDistances[i] - simd.thumbDistances[i])));
+        }
+    }
+
+    float checksum = 0;
+    double scalarNs = nanosecondsPerHand(hands, iterations, computeHandGeometryScalar, checksum);
+    double simdNs = nanosecondsPerHand(hands, iterations, computeHandGeometry, checksum);
+
+    std::cout << "Hand kernel (" << handKernelIsa() << "), " << kPoses << " poses x " << iterations << " iterations" << std::endl;
+    std::cout << "  scalar:     " << scalarNs << " ns/hand" << std::endl;
+    std::cout << "  vectorised: " << simdNs << " ns/hand (" << scalarNs / simdNs << "x)" << std::endl;
+    std::cout << "  max difference: " << maxAngleError << " deg, " << maxDistanceError << " mm";
+    if (scalarNaNs > 0) {
+        std::cout << " (" << scalarNaNs << " scalar NaN angles skipped)";
+    }
+    std::cout << std::endl;
+    std::cout << "  max error against double precision (" << Trig::name() << "): vectorised " << maxKernelError
+              << " deg, scalar " << maxScalarError << " deg" << std::endl;
+    std::cout << "  checksum " << checksum << std::endl;
+    if (maxKernelError > kMaxKernelErrorDegrees) {
+        std::cerr << "Kernel angle error above " << kMaxKernelErrorDegrees << " deg" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// end of HandKernelBenchmark.cpp //
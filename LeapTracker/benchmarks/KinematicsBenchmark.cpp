@@ -0,0 +1,103 @@
+//
+//  KinematicsBenchmark.cpp
+//  LeapTracker
+//
+//  Compares the quaternion kinematics path (computeHandKinematics) with the
+//  position-based hand geometry (computeHandGeometry) on synthetic hand
+//  poses: time per hand, and how far the unsigned position angles are from
+//  the total bend implied by the quaternion flexion and abduction. The run
+//  fails if they disagree by more than kMaxBendDifferenceDegrees.
+//
+//  Usage: KinematicsBenchmark [iterations]
+//
+#include "FastMath.hpp"
+#include "HandKernel.hpp"
+#include "LeapCStandIn/SyntheticHand.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+const int kPoses = 1024;
+const double kDegToRad = 3.14159265358979323846 / 180.0;
+
+// Both paths use atan2 through the Trig policy, so they agree to its error
+#if LEAPTRACKER_FAST_MATH
+const double kMaxBendDifferenceDegrees = 2 * fastmath::kAtan2MaxErrorDegrees + 1e-3;
+#else
+const double kMaxBendDifferenceDegrees = 1e-3;
+#endif
+
+template <typename Result, typename Kernel>
+double nanosecondsPerHand(const std::vector<LEAP_HAND>& hands, int iterations, Kernel kernel, float& checksum) {
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        for (const LEAP_HAND& hand : hands) {
+            kernel(hand, result);
+            checksum += reinterpret_cast<const float*>(&result)[it % 15];
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (double(iterations) * hands.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+    std::vector<LEAP_HAND> hands(kPoses);
+    SyntheticHand right(eLeapHandType_Right, 1, 0.0);
+    SyntheticHand left(eLeapHandType_Left, 2, 0.7);
+    for (int i = 0; i < kPoses; i++) {
+        (i % 2 ? left : right).generate(i / 120.0, hands[i]);
+    }
+
+    // The position path measures the whole bend between two bones, which the
+    // quaternion path splits into flexion and abduction
+    double maxBendDifference = 0;
+    double maxAbduction = 0;
+    double maxWristFlexion = 0;
+    for (const LEAP_HAND& hand : hands) {
+        HandGeometry geometry;
+        HandKinematics kinematics;
+        computeHandGeometry(hand, geometry);
+        computeHandKinematics(hand, kinematics);
+        for (int f = 0; f < 5; f++) {
+            for (int j = 0; j < 3; j++) {
+                // The thumb metacarpal has no length, so its position angle is not defined
+                if (geometry.boneLengths[f][j] == 0.0f) {
+                    continue;
+                }
+                double bend = std::acos(std::cos(kinematics.flexion[f][j] * kDegToRad) *
+                                        std::cos(kinematics.abduction[f][j] * kDegToRad)) / kDegToRad;
+                maxBendDifference = std::max(maxBendDifference, std::fabs(bend - geometry.jointAngles[f][j]));
+                maxAbduction = std::max(maxAbduction, double(std::fabs(kinematics.abduction[f][j])));
+            }
+        }
+        maxWristFlexion = std::max(maxWristFlexion, double(std::fabs(kinematics.wristFlexion)));
+    }
+
+    float checksum = 0;
+    double positionNs = nanosecondsPerHand<HandGeometry>(hands, iterations, computeHandGeometry, checksum);
+    double quaternionNs = nanosecondsPerHand<HandKinematics>(hands, iterations, computeHandKinematics, checksum);
+
+    std::cout << "Joint kinematics (" << handKernelIsa() << "), " << kPoses << " poses x " << iterations << " iterations" << std::endl;
+    std::cout << "  position (HandGeometry):     " << positionNs << " ns/hand" << std::endl;
+    std::cout << "  quaternion (HandKinematics): " << quaternionNs << " ns/hand (" << positionNs / quaternionNs << "x)" << std::endl;
+    std::cout << "  max bend difference: " << maxBendDifference << " deg" << std::endl;
+    std::cout << "  largest abduction " << maxAbduction << " deg, wrist flexion " << maxWristFlexion << " deg" << std::endl;
+    std::cout << "  checksum " << checksum << std::endl;
+    if (maxBendDifference > kMaxBendDifferenceDegrees) {
+        std::cerr << "Bend difference above " << kMaxBendDifferenceDegrees << " deg" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// end of KinematicsBenchmark.cpp //
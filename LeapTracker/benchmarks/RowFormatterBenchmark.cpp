@@ -0,0 +1,159 @@
+//
+//  RowFormatterBenchmark.cpp
+//  LeapTracker
+//
+//  Compares building CSV rows with RowFormatter against a std::stringstream
+//  per row, as processFrame used to. Checks that the default float format
+//  writes exactly what the stream wrote, and counts heap allocations while
+//  formatting rows after the first. Exits with status 1 if the output
+//  differs or steady-state rows allocate.
+//
+//  Usage: RowFormatterBenchmark [rows]
+//
+#include "RowFormatter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+
+// One row's worth of columns: positions in mm, angles in degrees, metrics 0..1
+const int kColumns = 58;
+const char* const kTimestamp = "2024-07-29 19:38:43.123456";
+
+std::vector<float> makeValues(int rows) {
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 180.0f);
+    std::uniform_real_distribution<float> metric(0.0f, 1.0f);
+    std::vector<float> values(static_cast<size_t>(rows) * kColumns);
+    for (size_t i = 0; i < values.size(); i++) {
+        int column = static_cast<int>(i % kColumns);
+        values[i] = column < 15 || (column >= 30 && column < 33) ? position(random)
+                  : column < 50 ? angle(random) : metric(random);
+    }
+    // Values that print differently in each format
+    values[0] = 0.0f;
+    values[1] = -0.0f;
+    values[2] = 1e-7f;
+    values[3] = 123456789.0f;
+    values[4] = std::nanf("");
+    values[5] = 100.0f;
+    return values;
+}
+
+std::string streamRow(const float* values, const std::string& client, int session, const std::string& exercise) {
+    std::stringstream ss;
+    ss << client << "," << session << "," << exercise << ",";
+    ss.write(kTimestamp, strlen(kTimestamp));
+    ss << "," << 1;
+    for (int c = 0; c < kColumns; c++) {
+        ss << "," << values[c];
+    }
+    ss << "\n";
+    return ss.str();
+}
+
+void formatRow(RowFormatter& row, const float* values) {
+    row.begin();
+    row.append(kTimestamp, strlen(kTimestamp));
+    row.appendField(static_cast<int64_t>(1));
+    for (int c = 0; c < kColumns; c++) {
+        row.appendField(values[c]);
+    }
+    row.end();
+}
+
+double nanosecondsPerRow(const std::vector<float>& values, int rows, RowFormatter::FloatFormat format, size_t& checksum,
+                         uint64_t& allocations) {
+    RowFormatter row("Alice,1,MakeAFist,", kColumns + 1, strlen(kTimestamp), format);
+    formatRow(row, values.data());
+    uint64_t before = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rows; r++) {
+        formatRow(row, values.data() + static_cast<size_t>(r) * kColumns);
+        checksum += row.size();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    allocations = allocationCount.load() - before;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / rows;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+int main(int argc, char* argv[]) {
+    int rows = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+    std::vector<float> values = makeValues(rows);
+    bool ok = true;
+
+    // The default format must not change the CSV
+    RowFormatter::FloatFormat general;
+    RowFormatter row("Alice,1,MakeAFist,", kColumns + 1, strlen(kTimestamp), general);
+    int mismatches = 0;
+    for (int r = 0; r < rows; r++) {
+        const float* rowValues = values.data() + static_cast<size_t>(r) * kColumns;
+        formatRow(row, rowValues);
+        std::string expected = streamRow(rowValues, "Alice", 1, "MakeAFist");
+        if (expected != std::string(row.data(), row.size())) {
+            if (mismatches++ == 0) {
+                std::cout << "First mismatch in row " << r << ":\n  stream:    " << expected
+                          << "  formatter: " << std::string(row.data(), row.size());
+            }
+        }
+    }
+    std::cout << "general:6 against std::stringstream: " << mismatches << " of " << rows << " rows differ "
+              << (mismatches == 0 ? "ok" : "FAILED") << std::endl;
+    ok = ok && mismatches == 0;
+
+    size_t checksum = 0;
+    uint64_t streamAllocations = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rows; r++) {
+        checksum += streamRow(values.data() + static_cast<size_t>(r) * kColumns, "Alice", 1, "MakeAFist").size();
+    }
+    double streamNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rows;
+    streamAllocations = allocationCount.load() - streamAllocations;
+    std::cout << "std::stringstream: " << streamNs << " ns/row, "
+              << static_cast<double>(streamAllocations) / rows << " allocations/row" << std::endl;
+
+    struct Case { const char* name; const char* format; };
+    const Case cases[] = { {"general:6", "general:6"}, {"shortest", "shortest"}, {"fixed:3", "fixed:3"} };
+    for (const Case& c : cases) {
+        uint64_t allocations = 0;
+        double ns = nanosecondsPerRow(values, rows, RowFormatter::parseFloatFormat(c.format), checksum, allocations);
+        std::cout << "RowFormatter " << c.name << ": " << ns << " ns/row (" << streamNs / ns << "x), "
+                  << allocations << " allocations " << (allocations == 0 ? "ok" : "FAILED") << std::endl;
+        ok = ok && allocations == 0;
+    }
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    return ok ? 0 : 1;
+}
+
+// end of RowFormatterBenchmark.cpp //
@@ -4,24 +4,182 @@
 //
 //  Created by Fergal Davis on 29/07/2024.
 //
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 #include "LeapTracker.hpp"
 
+// Parses "<client>,<session>,<exercise>[,<serial>]"
+static bool parseSessionSpec(const std::string& text, SessionSpec& spec) {
+    std::vector<std::string> fields;
+    std::stringstream ss(text);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 3 || fields.size() > 4 || fields[1].empty() ||
+        fields[1].find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    spec.clientName = fields[0];
+    spec.sessionNumber = std::stoi(fields[1]);
+    spec.exerciseName = fields[2];
+    if (fields.size() == 4) {
+        spec.deviceSerial = fields[3];
+    }
+    return true;
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <client_name> <session_number> <exercise_name> <osc_ip> <osc_port> <websocket_port> [options]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --ring-capacity <frames>           Frames buffered between polling and processing (default 64)" << std::endl;
+    std::cerr << "  --ring-policy <drop-oldest|block>  What to do when the frame ring is full (default drop-oldest)" << std::endl;
+    std::cerr << "  --stream background_frames" << std::endl;
+    std::cerr << "                                     Keep an optional LeapC stream enabled for the whole session" << std::endl;
+    std::cerr << "  --record-frames <path>             Save raw tracking frames for replay through the LeapC stand-in" << std::endl;
+    std::cerr << "  --timestamp-format <local|epoch>   Local date/time with microseconds (default) or integer epoch microseconds" << std::endl;
+    std::cerr << "  --output-rate <hz>                 Emit interpolated frames at a fixed rate instead of the device rate" << std::endl;
+    std::cerr << "  --output-delay <ms>                How far interpolated frames lag behind live tracking (default 20)" << std::endl;
+    std::cerr << "  --devices <count>                  Capture from up to this many controllers, one session each (default 1)" << std::endl;
+    std::cerr << "  --device-serial <serial>           Bind the command-line session to this controller" << std::endl;
+    std::cerr << "  --session <client>,<session>,<exercise>[,<serial>]" << std::endl;
+    std::cerr << "                                     Host another patient session in this process (may be repeated)" << std::endl;
+    std::cerr << "  --io-threads <count>               Threads serving the shared WebSocket listener (default 1)" << std::endl;
+    std::cerr << "  --joint-angles <position|quaternion>" << std::endl;
+    std::cerr << "                                     Derive joint angles from joint positions (default) or bone rotations" << std::endl;
+    std::cerr << "  --filter <none|one-euro|kalman>    Smooth the WebSocket and OSC output (default none)" << std::endl;
+    std::cerr << "  --log-format <csv|binary|both>     Session log format; binary is written next to the CSV as .ltsb (default csv)" << std::endl;
+    std::cerr << "  --csv-floats <general[:digits]|shortest|fixed[:decimals]>" << std::endl;
+    std::cerr << "                                     How CSV values are printed (default general:6)" << std::endl;
+    std::cerr << "  --csv-flush-ms <ms>                Write batched CSV rows at least this often (default 100)" << std::endl;
+    std::cerr << "  --csv-sync <never|stop|<seconds>>  When to fsync the CSV file (default stop)" << std::endl;
+    std::cerr << "  --log-compression <none|zstd>      Compress the session logs in independently decodable blocks (default none)" << std::endl;
+    std::cerr << "  --log-compression-level <level>    zstd level (default 3)" << std::endl;
+    std::cerr << "  --log-rotate-mb <MB>               Start a new log file part once a part reaches this size" << std::endl;
+    std::cerr << "  --log-rotate-minutes <minutes>     Start a new log file part after this long" << std::endl;
+    std::cerr << "  --journal-mb <MB>                  Keep a crash journal of this size next to each log (see LeapJournalRecover)" << std::endl;
+    std::cerr << "  --journal-sync-ms <ms>             msync the crash journal at least this often (default 1000)" << std::endl;
+    std::cerr << "  --bimanual                         Output each hand separately: WebSocket \"hands\" array, /leap/left/... and /leap/right/... OSC" << std::endl;
+    std::cerr << "  --calibrate                        Record this patient's metric ranges and save them when tracking stops" << std::endl;
+    std::cerr << "  --calibration-dir <path>           Directory of <client_name>.calibration files (default .)" << std::endl;
+    std::cerr << "  --dashboard                        Show a live status view of each session on the terminal" << std::endl;
+    std::cerr << "  --dashboard-ms <ms>                How often the status view is refreshed (default 250)" << std::endl;
+    std::cerr << "  --verbose-rows                     Print every CSV row to stdout as it is logged, instead of the status view" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 7) {
-        std::cerr << "Usage: " << argv[0] << " <client_name> <session_number> <exercise_name> <osc_ip> <osc_port> <websocket_port>" << std::endl;
+        printUsage(argv[0]);
         return 1;
     }
 
     std::string clientName = argv[1];
-    int sessionNumber = std::stoi(argv[2]);
     std::string exerciseName = argv[3];
     const char* oscIP = argv[4];
-    int oscPort = std::stoi(argv[5]);
-    int wsPort = std::stoi(argv[6]);
+    int sessionNumber, oscPort, wsPort;
+    try {
+        sessionNumber = std::stoi(argv[2]);
+        oscPort = std::stoi(argv[5]);
+        wsPort = std::stoi(argv[6]);
+    } catch (const std::logic_error&) {
+        std::cerr << "Session number, OSC port and WebSocket port must be integers" << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    LeapTrackerOptions options;
+    for (int i = 7; i < argc; i++) {
+        std::string arg = argv[i];
+        // The parse functions and std::sto* throw invalid_argument or out_of_range on bad values
+        try {
+            if (arg == "--ring-capacity" && i + 1 < argc) {
+                options.frameRingCapacity = std::stoul(argv[++i]);
+                if (options.frameRingCapacity == 0) {
+                    throw std::invalid_argument("the frame ring needs at least one slot");
+                }
+            } else if (arg == "--ring-policy" && i + 1 < argc) {
+                options.frameRingPolicy = FrameRing::parsePolicy(argv[++i]);
+            } else if (arg == "--stream" && i + 1 < argc) {
+                PolicyManager::Stream stream;
+                if (!PolicyManager::parseStream(argv[++i], stream)) {
+                    std::cerr << "Unknown stream: " << argv[i] << std::endl;
+                    return 1;
+                }
+                options.sessionStreams.push_back(stream);
+            } else if (arg == "--record-frames" && i + 1 < argc) {
+                options.frameRecordingPath = argv[++i];
+            } else if (arg == "--timestamp-format" && i + 1 < argc) {
+                options.timestampFormat = parseTimestampFormat(argv[++i]);
+            } else if (arg == "--output-rate" && i + 1 < argc) {
+                options.outputRate = std::stod(argv[++i]);
+            } else if (arg == "--devices" && i + 1 < argc) {
+                options.deviceCount = std::stoi(argv[++i]);
+            } else if (arg == "--device-serial" && i + 1 < argc) {
+                options.deviceSerial = argv[++i];
+            } else if (arg == "--session" && i + 1 < argc) {
+                SessionSpec spec;
+                if (!parseSessionSpec(argv[++i], spec)) {
+                    std::cerr << "Invalid session, expected <client>,<session>,<exercise>[,<serial>]: " << argv[i] << std::endl;
+                    return 1;
+                }
+                options.extraSessions.push_back(spec);
+            } else if (arg == "--io-threads" && i + 1 < argc) {
+                options.ioThreadCount = std::stoi(argv[++i]);
+            } else if (arg == "--joint-angles" && i + 1 < argc) {
+                options.jointAngleSource = parseJointAngleSource(argv[++i]);
+            } else if (arg == "--log-format" && i + 1 < argc) {
+                options.logFormat = parseSessionLogFormat(argv[++i]);
+            } else if (arg == "--csv-floats" && i + 1 < argc) {
+                options.csvFloatFormat = RowFormatter::parseFloatFormat(argv[++i]);
+            } else if (arg == "--csv-flush-ms" && i + 1 < argc) {
+                options.csvWriter.flushInterval = std::chrono::milliseconds(std::stoi(argv[++i]));
+            } else if (arg == "--csv-sync" && i + 1 < argc) {
+                AsyncFileWriter::parseSyncPolicy(argv[++i], options.csvWriter);
+            } else if (arg == "--log-compression" && i + 1 < argc) {
+                options.csvWriter.file.compression = LogFile::parseCompression(argv[++i]);
+            } else if (arg == "--log-compression-level" && i + 1 < argc) {
+                options.csvWriter.file.compressionLevel = std::stoi(argv[++i]);
+            } else if (arg == "--log-rotate-mb" && i + 1 < argc) {
+                options.csvWriter.file.rotateBytes = static_cast<uint64_t>(std::stod(argv[++i]) * 1024 * 1024);
+            } else if (arg == "--log-rotate-minutes" && i + 1 < argc) {
+                options.csvWriter.file.rotateInterval = std::chrono::seconds(static_cast<int64_t>(std::stod(argv[++i]) * 60));
+            } else if (arg == "--journal-mb" && i + 1 < argc) {
+                options.csvWriter.journalBytes = static_cast<size_t>(std::stod(argv[++i]) * 1024 * 1024);
+            } else if (arg == "--journal-sync-ms" && i + 1 < argc) {
+                options.csvWriter.journalSyncInterval = std::chrono::milliseconds(std::stoi(argv[++i]));
+            } else if (arg == "--bimanual") {
+                options.bimanual = true;
+            } else if (arg == "--calibrate") {
+                options.calibrate = true;
+            } else if (arg == "--calibration-dir" && i + 1 < argc) {
+                options.calibrationDirectory = argv[++i];
+            } else if (arg == "--dashboard") {
+                options.dashboard = true;
+            } else if (arg == "--dashboard-ms" && i + 1 < argc) {
+                options.dashboardInterval = std::chrono::milliseconds(std::max(20, std::stoi(argv[++i])));
+            } else if (arg == "--verbose-rows") {
+                options.verboseRows = true;
+            } else if (arg == "--filter" && i + 1 < argc) {
+                options.filterType = ChannelFilter::parseType(argv[++i]);
+            } else if (arg == "--output-delay" && i + 1 < argc) {
+                options.outputDelayMicros = static_cast<int64_t>(std::stod(argv[++i]) * 1000);
+            } else {
+                std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+                return 1;
+            }
+        } catch (const std::logic_error& e) {
+            std::cerr << "Invalid value for " << arg << ": " << e.what() << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
 
-    LeapTracker tracker(clientName, sessionNumber, exerciseName, oscIP, oscPort, wsPort);
+    LeapTracker tracker(clientName, sessionNumber, exerciseName, oscIP, oscPort, wsPort, options);
 
     tracker.startTracking();
     std::cout << "Tracking started. Type 'quit' to stop." << std::endl;
@@ -0,0 +1,120 @@
+//
+//  LeapJournalRecover.cpp
+//  LeapTracker
+//
+//  Completes a session log from the journal a crashed tracker left behind
+//  (--journal-mb). The part named in the journal's last commit is cut back
+//  to the size it had then, and the rows appended after that commit are
+//  written after it, as one more zstd frame if the part is compressed. Only
+//  those rows are read, so recovery is quick however large the journal is.
+//  Running it twice gives the same file. The journal is deleted afterwards
+//  unless --keep-journal is given.
+//
+//  Usage: LeapJournalRecover <log.csv.journal> [--dry-run] [--keep-journal]
+//
+#include "LogFile.hpp"
+#include "SessionJournal.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#ifdef LEAPTRACKER_ZSTD
+#include <zstd.h>
+#endif
+
+int main(int argc, char** argv) {
+    std::string journalPath;
+    bool dryRun = false;
+    bool keepJournal = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--dry-run") {
+            dryRun = true;
+        } else if (arg == "--keep-journal") {
+            keepJournal = true;
+        } else if (journalPath.empty()) {
+            journalPath = arg;
+        } else {
+            journalPath.clear();
+            break;
+        }
+    }
+    if (journalPath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <log.csv.journal> [--dry-run] [--keep-journal]" << std::endl;
+        return 1;
+    }
+
+    SessionJournal::Recovery recovery;
+    std::string error;
+    if (!SessionJournal::recover(journalPath, recovery, error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    const JournalCommit& commit = recovery.commit;
+    std::string partPath(commit.partPath, commit.pathLength);
+    std::cout << "Log part: " << partPath << (commit.compressed ? " (zstd)" : "") << std::endl;
+    std::cout << "Complete up to " << commit.partBytes << " bytes on disk (" << commit.streamOffset << " bytes of rows)" << std::endl;
+    std::cout << "Recovered " << recovery.rows.size() << " bytes of rows from the journal" << std::endl;
+    if (recovery.lostBytes > 0) {
+        std::cerr << "Warning: " << recovery.lostBytes << " bytes of rows were overwritten in the journal or torn by the crash"
+                  << " and cannot be recovered" << std::endl;
+    }
+    if (dryRun) {
+        return 0;
+    }
+
+    std::vector<char> payload(recovery.rows.begin(), recovery.rows.end());
+    if (commit.compressed && !payload.empty()) {
+#ifdef LEAPTRACKER_ZSTD
+        std::vector<char> frame(ZSTD_compressBound(payload.size()));
+        size_t size = ZSTD_compress(frame.data(), frame.size(), payload.data(), payload.size(), 3);
+        if (ZSTD_isError(size)) {
+            std::cerr << "Failed to compress the recovered rows: " << ZSTD_getErrorName(size) << std::endl;
+            return 1;
+        }
+        frame.resize(size);
+        payload.swap(frame);
+#else
+        std::cerr << "The log is compressed; rebuild with -DLEAPTRACKER_ENABLE_ZSTD=ON to recover it" << std::endl;
+        return 1;
+#endif
+    }
+
+    int fd = ::open(partPath.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Cannot open " << partPath << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    bool ok = ftruncate(fd, static_cast<off_t>(commit.partBytes)) == 0;
+    size_t written = 0;
+    while (ok && written < payload.size()) {
+        ssize_t n = pwrite(fd, payload.data() + written, payload.size() - written, static_cast<off_t>(commit.partBytes + written));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        ok = n > 0;
+        written += ok ? static_cast<size_t>(n) : 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    if (!ok) {
+        std::cerr << "Failed to write " << partPath << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return 1;
+    }
+    ::close(fd);
+
+    if (commit.compressed) {
+        // The frame list changed; LeapLogDecompress rebuilds the index
+        unlink(LogFile::indexPath(partPath).c_str());
+    }
+    if (!keepJournal) {
+        unlink(journalPath.c_str());
+    }
+    std::cout << "Wrote " << partPath << " (" << commit.partBytes + payload.size() << " bytes)" << std::endl;
+    return 0;
+}
+
+// end of LeapJournalRecover.cpp //
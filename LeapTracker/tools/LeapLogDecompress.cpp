@@ -0,0 +1,212 @@
+//
+//  LeapLogDecompress.cpp
+//  LeapTracker
+//
+//  Decompresses a compressed session log part (--log-compression zstd) with
+//  one thread per core. Block offsets come from the part's .index.json, or,
+//  for a part whose session ended in a crash, from walking the zstd frame
+//  headers; the index is then written so the next reader need not walk them.
+//  A torn last frame is reported and dropped.
+//
+//  Usage: LeapLogDecompress <log.csv.zst> [output] [--threads <count>]
+//
+#include "LogFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <zstd.h>
+
+namespace {
+
+// Reads the "blocks" array of an index written by LogFile
+bool readIndex(const std::string& path, std::vector<LogFile::Block>& blocks) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    std::string json = text.str();
+    size_t position = json.find("\"blocks\"");
+    if (position == std::string::npos) {
+        return false;
+    }
+    std::vector<uint64_t> numbers;
+    const char* p = json.c_str() + position;
+    while (*p) {
+        if (*p >= '0' && *p <= '9') {
+            char* end;
+            numbers.push_back(std::strtoull(p, &end, 10));
+            p = end;
+        } else {
+            p++;
+        }
+    }
+    if (numbers.size() % 4 != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < numbers.size(); i += 4) {
+        blocks.push_back({ numbers[i], numbers[i + 1], numbers[i + 2], numbers[i + 3] });
+    }
+    return true;
+}
+
+// Finds the frames from their headers; stops at the first incomplete one
+void scanFrames(const char* data, size_t size, std::vector<LogFile::Block>& blocks) {
+    uint64_t offset = 0;
+    uint64_t rawOffset = 0;
+    while (offset < size) {
+        size_t frameSize = ZSTD_findFrameCompressedSize(data + offset, size - offset);
+        unsigned long long rawSize = ZSTD_isError(frameSize) ? ZSTD_CONTENTSIZE_ERROR
+                                                             : ZSTD_getFrameContentSize(data + offset, frameSize);
+        if (rawSize == ZSTD_CONTENTSIZE_ERROR || rawSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+            std::cerr << "Dropping " << size - offset << " bytes of incomplete frame at offset " << offset << std::endl;
+            return;
+        }
+        blocks.push_back({ offset, frameSize, rawOffset, rawSize });
+        offset += frameSize;
+        rawOffset += rawSize;
+    }
+}
+
+void writeIndex(const std::string& path, const std::vector<LogFile::Block>& blocks) {
+    std::ofstream index(path, std::ofstream::out | std::ofstream::trunc);
+    uint64_t rawBytes = blocks.empty() ? 0 : blocks.back().rawOffset + blocks.back().rawSize;
+    index << "{\n  \"compression\": \"zstd\",\n  \"rawBytes\": " << rawBytes
+          << ",\n  \"blockFields\": [\"offset\", \"size\", \"rawOffset\", \"rawSize\"],\n  \"blocks\": [";
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const LogFile::Block& b = blocks[i];
+        index << (i ? ",\n    [" : "\n    [") << b.offset << ", " << b.size << ", " << b.rawOffset << ", " << b.rawSize << "]";
+    }
+    index << "\n  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threadCount = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || paths.size() > 2) {
+        std::cerr << "Usage: " << argv[0] << " <log.csv.zst> [output] [--threads <count>]" << std::endl;
+        return 1;
+    }
+    const std::string& inputPath = paths[0];
+    std::string outputPath = paths.size() == 2 ? paths[1] : inputPath;
+    if (paths.size() == 1) {
+        if (outputPath.size() > 4 && outputPath.compare(outputPath.size() - 4, 4, ".zst") == 0) {
+            outputPath.resize(outputPath.size() - 4);
+        } else {
+            outputPath += ".out";
+        }
+    }
+
+    int input = ::open(inputPath.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (input < 0 || fstat(input, &status) != 0) {
+        std::cerr << "Cannot open " << inputPath << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    const char* data = nullptr;
+    if (size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, input, 0);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Cannot map " << inputPath << ": " << strerror(errno) << std::endl;
+            return 1;
+        }
+        data = static_cast<const char*>(mapping);
+    }
+    ::close(input);
+
+    std::vector<LogFile::Block> blocks;
+    std::string indexPath = LogFile::indexPath(inputPath);
+    bool indexed = readIndex(indexPath, blocks);
+    for (const LogFile::Block& block : blocks) {
+        if (block.offset + block.size > size) {
+            indexed = false;
+        }
+    }
+    if (!indexed) {
+        blocks.clear();
+        std::cout << "No usable index, walking the frames of " << inputPath << std::endl;
+        scanFrames(data, size, blocks);
+        writeIndex(indexPath, blocks);
+    }
+    uint64_t rawBytes = blocks.empty() ? 0 : blocks.back().rawOffset + blocks.back().rawSize;
+
+    int output = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (output < 0 || ftruncate(output, static_cast<off_t>(rawBytes)) != 0) {
+        std::cerr << "Cannot create " << outputPath << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Each thread takes the next block, decompresses it and writes it at its own offset
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto worker = [&]() {
+        ZSTD_DCtx* context = ZSTD_createDCtx();
+        std::vector<char> buffer;
+        for (size_t i = next++; i < blocks.size() && !failed; i = next++) {
+            const LogFile::Block& block = blocks[i];
+            buffer.resize(block.rawSize);
+            size_t n = ZSTD_decompressDCtx(context, buffer.data(), buffer.size(), data + block.offset, block.size);
+            if (ZSTD_isError(n) || n != block.rawSize) {
+                std::cerr << "Block " << i << " at offset " << block.offset << " is corrupt" << std::endl;
+                failed = true;
+                break;
+            }
+            size_t written = 0;
+            while (written < n) {
+                ssize_t w = pwrite(output, buffer.data() + written, n - written, static_cast<off_t>(block.rawOffset + written));
+                if (w < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (w <= 0) {
+                    std::cerr << "Failed to write " << outputPath << ": " << strerror(errno) << std::endl;
+                    failed = true;
+                    break;
+                }
+                written += static_cast<size_t>(w);
+            }
+        }
+        ZSTD_freeDCtx(context);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < std::min<size_t>(threadCount, std::max<size_t>(1, blocks.size())); t++) {
+        threads.emplace_back(worker);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ::close(output);
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+    }
+    if (failed) {
+        return 1;
+    }
+    std::cout << "Wrote " << rawBytes << " bytes from " << blocks.size() << " blocks to " << outputPath << std::endl;
+    return 0;
+}
+
+// end of LeapLogDecompress.cpp //
@@ -0,0 +1,103 @@
+//
+//  LeapSessionToCsv.cpp
+//  LeapTracker
+//
+//  Converts a binary session log (.ltsb) to the tracker's CSV layout, so the
+//  analysis scripts read it unchanged. Values are printed as the tracker
+//  prints them (--csv-floats as for the tracker); local timestamps use this
+//  machine's time zone. The default output name is the tracker's own CSV
+//  path when it logged both formats, so an existing file is only replaced
+//  with --force.
+//
+//  Usage: LeapSessionToCsv <session.ltsb> [output.csv] [--timestamp-format <local|epoch>]
+//                          [--csv-floats <general[:digits]|shortest|fixed[:decimals]>] [--force]
+//
+#include "RowFormatter.hpp"
+#include "SessionFile.hpp"
+#include "TimestampFormat.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    TimestampFormat timestampFormat = TimestampFormat::LocalMicros;
+    RowFormatter::FloatFormat floatFormat;
+    bool force = false;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--timestamp-format" && i + 1 < argc) {
+                timestampFormat = parseTimestampFormat(argv[++i]);
+            } else if (arg == "--csv-floats" && i + 1 < argc) {
+                floatFormat = RowFormatter::parseFloatFormat(argv[++i]);
+            } else if (arg == "--force") {
+                force = true;
+            } else {
+                paths.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (paths.empty() || paths.size() > 2) {
+        std::cerr << "Usage: " << argv[0] << " <session.ltsb> [output.csv] [--timestamp-format <local|epoch>]"
+                  << " [--csv-floats <general[:digits]|shortest|fixed[:decimals]>] [--force]" << std::endl;
+        return 1;
+    }
+
+    SessionFileReader reader;
+    if (!reader.open(paths[0])) {
+        std::cerr << reader.error() << std::endl;
+        return 1;
+    }
+    std::string outputPath = paths.size() == 2 ? paths[1] : paths[0].substr(0, paths[0].find_last_of('.')) + ".csv";
+    if (!force && access(outputPath.c_str(), F_OK) == 0) {
+        std::cerr << outputPath << " already exists (it may be the tracker's own CSV log); give another output path or --force"
+                  << std::endl;
+        return 1;
+    }
+    std::ofstream output(outputPath);
+    if (!output) {
+        std::cerr << "Failed to open output file at: " << outputPath << std::endl;
+        return 1;
+    }
+
+    SessionColumns columns = reader.columns();
+    std::vector<ColumnSpan<float>> values;
+    for (size_t c = 0; c < reader.columnCount(); c++) {
+        values.push_back(reader.values(c));
+    }
+    ColumnSpan<int64_t> epochMicros = reader.epochMicros();
+    ColumnSpan<int32_t> handTypes = reader.handTypes();
+
+    std::string prefix = reader.clientName() + "," + std::to_string(reader.header().sessionNumber) + "," + reader.exerciseName() + ",";
+    RowFormatter row(prefix, columns.size() + 1, DEVICE_CLOCK_TIMESTAMP_SIZE, floatFormat);
+
+    output << columns.csvHeader();
+    char timestamp[DEVICE_CLOCK_TIMESTAMP_SIZE];
+    for (size_t r = 0; r < reader.recordCount(); r++) {
+        int64_t epoch = epochMicros[r];
+        size_t timestampLength = formatTimestamp(epoch, timestampFormat, localUtcOffsetSeconds(epoch), timestamp);
+        row.begin();
+        row.append(timestamp, timestampLength);
+        row.appendField(static_cast<int64_t>(handTypes[r]));
+        for (const ColumnSpan<float>& column : values) {
+            row.appendField(column[r]);
+        }
+        row.end();
+        output.write(row.data(), row.size());
+    }
+
+    if (!output.flush()) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << reader.recordCount() << " rows to " << outputPath << std::endl;
+    return 0;
+}
+
+// end of LeapSessionToCsv.cpp //